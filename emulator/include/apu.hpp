@@ -1,29 +1,65 @@
 #ifndef APU_HPP
 #define APU_HPP
 
-#include <SDL2/SDL.h>
 #include <cstdint>
 #include <vector>
 #include <cmath>
+#include <atomic>
+#include <mutex>
+#include "state.hpp"
+#include "frontend.hpp"
 
 class APU {
 public:
     APU();
-    ~APU();
-
-    bool init();
-    void cleanup();
 
     // Memory-mapped register interface
     void write8(uint32_t addr, uint8_t data);
     uint8_t read8(uint32_t addr);
 
-    // Audio callback for SDL
-    static void audio_callback(void* userdata, uint8_t* stream, int len);
+    // Channel registers and oscillator phases (not the output queue)
+    void save_state(StateWriter& w);
+    bool load_state(StateReader& r);
+
+    // Output rate, chosen by the frontend to match its device
+    void set_sample_rate(int rate);
+    int get_sample_rate() const { return sample_rate; }
+
+    // Pull mode (no sink): a frontend thread calls render() for as many
+    // frames as its device wants, straight from the live register state.
+    // Push mode: end_frame() renders one emulated frame into the sink.
+    void set_sink(AudioSink* s);
+    void render(float* out, int frames);
+    void end_frame();
+
+    // Silences output (fast-forward). Push mode stops producing frames.
+    void set_muted(bool mute) { muted = mute; }
+    bool is_muted() const { return muted; }
+
+    // Run-ahead: frames emulated while speculating never reach the output.
+    // Pull mode is held off so it can't play speculative register writes.
+    void set_speculating(bool on);
+
+    // Rollback re-simulation: the frames were already heard once, so push
+    // mode doesn't send them to the sink again. Registers update as usual.
+    void set_replaying(bool on) { replaying = on; }
+
+    static constexpr int FRAMES_PER_SECOND = 60;
 
 private:
-    SDL_AudioSpec want, have;
-    SDL_AudioDeviceID deviceId;
+    // Renders interleaved stereo float frames at sample_rate
+    void mix(float* out, int frames);
+
+    // Guards the live registers against a pull-mode render() on another thread
+    std::recursive_mutex lock;
+
+    int sample_rate = 48000;
+    AudioSink* sink = nullptr;
+    std::atomic<bool> muted{false};
+    bool speculating = false;
+    bool replaying = false;
+    std::vector<float> frame_buffer; // end_frame() scratch
+    double frame_accum = 0.0;
 
     // Pulse/Sine Wave Channel (Hi-Fi)
     struct Channel {
@@ -31,10 +67,28 @@ private:
         float frequency = 0.0f;
         float volume = 0.5f;
         float phase = 0.0f;
+        float phase_inc = 0.0f; // frequency / sample_rate
+        float gain_l = 0.70710678f; // Equal-power pan gains (center)
+        float gain_r = 0.70710678f;
         int type = 0; // 0=Square, 1=Sine, 2=Triangle
-    } channels[4];
+    };
+
+    struct Registers {
+        Channel channels[4];
+        uint32_t freq_raw[4] = {0, 0, 0, 0};
+        uint8_t pan_raw[4] = {128, 128, 128, 128}; // 0=Left, 128=Center, 255=Right
+    };
+
+    // mix() always plays live. While speculating, register writes and state
+    // loads go to a shadow copy instead, so the output never hears a
+    // speculative frame and render() never waits for one.
+    Registers live;
+    Registers shadow;
+    Registers* regs = &live;
 
-    uint32_t freq_raw[4] = {0, 0, 0, 0};
+    // Register map (offsets from APU_START)
+    static constexpr uint32_t REG_WAVE = 0x00; // 4 bytes per channel: freq lo, freq hi, ctrl, volume
+    static constexpr uint32_t REG_PAN  = 0x10; // 1 byte per channel
 };
 
 #endif
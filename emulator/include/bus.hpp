@@ -5,6 +5,7 @@
 #include <cstdint>
 #include <iostream>
 #include "apu.hpp"
+#include "state.hpp"
 
 class Bus {
 public:
@@ -24,11 +25,59 @@ public:
     void load_rom(const std::vector<uint8_t>& data);
     uint8_t* get_vram_ptr() { return vram.data(); }
 
+    // Interrupt controller: devices raise lines, the guest acks by writing 1s
+    // to IRQ_PENDING. The CPU sees the OR of pending & enabled as MEIP.
+    void raise_irq(uint32_t lines) { irq_pending |= lines; }
+    bool irq_line() const { return (irq_pending & irq_enable) != 0; }
+
+    static constexpr uint32_t IRQ_VBLANK = 1u << 0;
+
+    // Joypad registers: one byte per player at the start of the JOY region
+    static constexpr uint32_t JOY1 = 0x02000000;
+    static constexpr uint32_t JOY2 = 0x02000001;
+
+    // System clock: the CPU ticks it once per retired instruction and idle
+    // time is skipped forward. mtime runs at TIMER_HZ derived from it.
+    void tick() { cycles++; }
+    void advance_to(uint64_t cycle) { if (cycle > cycles) cycles = cycle; }
+    uint64_t get_cycles() const { return cycles; }
+    uint64_t get_mtime() const { return cycles / CYCLES_PER_TICK; }
+    bool timer_pending() const { return cycles >= mtimecmp_cycle; }
+    // Cycle at which the timer fires next, or UINT64_MAX if none is ahead
+    uint64_t next_timer_event() const { return timer_pending() ? UINT64_MAX : mtimecmp_cycle; }
+
+    // Dirty page tracking for snapshots. RAM and VRAM are addressed as one
+    // run of 4 KiB pages (RAM first). Writes through get_vram_ptr() bypass
+    // the bus, so those callers must report what they touched.
+    static constexpr uint32_t PAGE_SHIFT = 12;
+    static constexpr uint32_t PAGE_SIZE  = 1u << PAGE_SHIFT;
+    static constexpr uint32_t RAM_PAGES  = 0x01000000 >> PAGE_SHIFT;
+    static constexpr uint32_t STATE_PAGES = RAM_PAGES + (0x01000000 >> PAGE_SHIFT);
+
+    uint8_t* page_data(uint32_t page) {
+        return page < RAM_PAGES ? &ram[page << PAGE_SHIFT] : &vram[(page - RAM_PAGES) << PAGE_SHIFT];
+    }
+    const std::vector<uint32_t>& dirty_pages() const { return dirty_list; }
+    void clear_dirty();
+    void mark_page_dirty(uint32_t page) {
+        if (!page_dirty[page]) { page_dirty[page] = 1; dirty_list.push_back(page); }
+    }
+    void mark_vram_dirty(uint32_t offset, uint32_t len);
+
+    // Registers and device glue (RAM/VRAM contents go through the page API)
+    void save_state(StateWriter& w) const;
+    bool load_state(StateReader& r);
+
+    static constexpr uint32_t CPU_HZ = 30000000;
+    static constexpr uint32_t TIMER_HZ = 1000000;
+    static constexpr uint32_t CYCLES_PER_TICK = CPU_HZ / TIMER_HZ;
+    static constexpr uint32_t CYCLES_PER_FRAME = CPU_HZ / 60;
+
 private:
     std::vector<uint8_t> ram;      // 16 MB WRAM (0x01000000)
     std::vector<uint8_t> rom_area; // 16 MB ROM Area (0x00010000)
     std::vector<uint8_t> vram;     // 16 MB VRAM (0x03000000)
-    uint8_t joy_state[256];        // Input (0x02000000)
+    uint8_t joy_state[256] = {};   // Input (0x02000000)
     
     // Constants for memory mapping
     static constexpr uint32_t ROM_START = 0x00010000;
@@ -42,9 +91,21 @@ private:
     static constexpr uint32_t APU_START = 0x02000100;
     static constexpr uint32_t APU_SIZE  = 0x00000100;
     static constexpr uint32_t HLE_BRIDGE = 0x0200FFF0;
+    static constexpr uint32_t IRQ_START = 0x02000200; // +0 PENDING (W1C), +4 ENABLE
+    static constexpr uint32_t IRQ_SIZE  = 0x00000008;
+    static constexpr uint32_t TIMER_START = 0x02000300; // +0 MTIME (RO), +8 MTIMECMP
+    static constexpr uint32_t TIMER_SIZE  = 0x00000010;
 
     APU* apu = nullptr;
     uint8_t hle_bridge_data = 0;
+    uint32_t irq_pending = 0;
+    uint32_t irq_enable = 0;
+    uint64_t cycles = 0;
+    uint64_t mtimecmp = UINT64_MAX;
+    uint64_t mtimecmp_cycle = UINT64_MAX;
+
+    std::vector<uint8_t> page_dirty;   // One flag per state page
+    std::vector<uint32_t> dirty_list;  // Pages flagged since clear_dirty()
 };
 
 #endif
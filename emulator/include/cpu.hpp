@@ -14,14 +14,68 @@ public:
     void step(bool debug = false);
     std::string disassemble(uint32_t instr);
 
+    // True while parked in WFI with no enabled interrupt pending
+    bool is_waiting() const { return waiting; }
+    uint64_t get_instret() const { return instret; }
+
+    void save_state(StateWriter& w) const;
+    bool load_state(StateReader& r);
+
     // Registers
     uint32_t pc;
     uint32_t regs[32];
 
+    // Machine-mode CSR numbers
+    static constexpr uint16_t CSR_MSTATUS  = 0x300;
+    static constexpr uint16_t CSR_MIE      = 0x304;
+    static constexpr uint16_t CSR_MTVEC    = 0x305;
+    static constexpr uint16_t CSR_MSCRATCH = 0x340;
+    static constexpr uint16_t CSR_MEPC     = 0x341;
+    static constexpr uint16_t CSR_MCAUSE   = 0x342;
+    static constexpr uint16_t CSR_MTVAL    = 0x343;
+    static constexpr uint16_t CSR_MIP      = 0x344;
+    static constexpr uint16_t CSR_MCYCLE   = 0xB00;
+    static constexpr uint16_t CSR_MINSTRET = 0xB02;
+    static constexpr uint16_t CSR_MCYCLEH  = 0xB80;
+    static constexpr uint16_t CSR_MINSTRETH = 0xB82;
+    static constexpr uint16_t CSR_CYCLE    = 0xC00;
+    static constexpr uint16_t CSR_TIME     = 0xC01;
+    static constexpr uint16_t CSR_INSTRET  = 0xC02;
+    static constexpr uint16_t CSR_CYCLEH   = 0xC80;
+    static constexpr uint16_t CSR_TIMEH    = 0xC81;
+    static constexpr uint16_t CSR_INSTRETH = 0xC82;
+
+    static constexpr uint32_t MSTATUS_MIE  = 1u << 3;
+    static constexpr uint32_t MSTATUS_MPIE = 1u << 7;
+    static constexpr uint32_t MSTATUS_MPP  = 3u << 11;
+    static constexpr uint32_t MIP_MTIP     = 1u << 7;  // Timer (mtime >= mtimecmp)
+    static constexpr uint32_t MIP_MEIP     = 1u << 11; // External (IRQ controller)
+
+    static constexpr uint32_t CAUSE_INTERRUPT  = 0x80000000;
+    static constexpr uint32_t CAUSE_BREAKPOINT = 3;
+    static constexpr uint32_t CAUSE_ECALL_M    = 11;
+
 private:
     Bus& bus;
 
+    // Trap state
+    uint32_t csr_mstatus = 0;
+    uint32_t csr_mie = 0;
+    uint32_t csr_mip = 0;
+    uint32_t csr_mtvec = 0;
+    uint32_t csr_mscratch = 0;
+    uint32_t csr_mepc = 0;
+    uint32_t csr_mcause = 0;
+    uint32_t csr_mtval = 0;
+    bool waiting = false;
+    uint64_t instret = 0;
+
     void execute(uint32_t instr);
+    void execute_system(uint32_t instr);
+    void trap(uint32_t cause, uint32_t epc);
+    uint32_t sample_mip() const; // Current interrupt lines, as mip bits
+    uint32_t csr_read(uint16_t csr);
+    void csr_write(uint16_t csr, uint32_t value);
 };
 
 #endif
@@ -0,0 +1,45 @@
+#ifndef FARM_HPP
+#define FARM_HPP
+
+#include <vector>
+#include <cstdint>
+#include <string>
+
+// Runs many independent headless machines on a pool of worker threads.
+// Every job builds its own Machine, so nothing is shared between workers
+// except the job list and the result slots they write to.
+struct FarmJob {
+    std::string rom;
+    std::string input;   // Movie file driving the joypad, or empty for none
+    uint32_t frames = 0;
+};
+
+struct FarmResult {
+    bool ok = false;
+    std::string error;
+    uint64_t fb_hash = 0;     // Final framebuffer
+    uint64_t video_hash = 0;  // Chained over every frame's framebuffer
+    uint64_t audio_hash = 0;  // Chained over every frame's rendered samples
+    uint32_t mismatches = 0;  // Frames whose hash differs from the movie's
+    double wall_ms = 0.0;
+    uint64_t instret = 0;
+    uint64_t cycles = 0;
+};
+
+class Farm {
+public:
+    explicit Farm(int threads);
+
+    std::vector<FarmResult> run(const std::vector<FarmJob>& jobs);
+    static FarmResult run_job(const FarmJob& job);
+
+    // One line per job: "<rom> <frames> [movie]", '#' starts a comment
+    static bool load_jobs(const std::string& path, std::vector<FarmJob>& jobs);
+
+    static constexpr int AUDIO_RATE = 48000;
+
+private:
+    int threads;
+};
+
+#endif
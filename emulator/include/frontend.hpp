@@ -0,0 +1,33 @@
+#ifndef FRONTEND_HPP
+#define FRONTEND_HPP
+
+#include <cstdint>
+
+// The core never talks to a window, an audio device or a keyboard. A
+// frontend implements these and wires them to a Machine.
+
+// Receives composed frames (ARGB8888, width * height, row-major)
+class VideoSink {
+public:
+    virtual ~VideoSink() {}
+    virtual void present(const uint32_t* pixels, int width, int height) = 0;
+};
+
+// Receives the APU's output one emulated frame at a time, as interleaved
+// stereo float at APU::get_sample_rate()
+class AudioSink {
+public:
+    virtual ~AudioSink() {}
+    virtual void write(const float* stereo, int frames) = 0;
+    // Multiplier on the nominal samples per frame, for rate control
+    virtual float rate_ratio() { return 1.0f; }
+};
+
+// Joypad bytes (bit 0 Up .. bit 7 Select) for player 0 or 1
+class InputSource {
+public:
+    virtual ~InputSource() {}
+    virtual uint8_t poll_joy(int player) = 0;
+};
+
+#endif
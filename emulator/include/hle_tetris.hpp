@@ -0,0 +1,44 @@
+#ifndef HLE_TETRIS_HPP
+#define HLE_TETRIS_HPP
+
+#include "bus.hpp"
+#include "state.hpp"
+#include <cstdint>
+
+// --- Native Tetris HLE Logic (Pocket Edition 160x144) ---
+// Runs when the guest pokes the HLE bridge at 0x0200FFF0.
+class HleTetris {
+public:
+    static constexpr int BOARD_WIDTH = 10;
+    static constexpr int BOARD_HEIGHT = 20;
+    static constexpr int BLOCK_SIZE = 6;
+    static constexpr int BOARD_X = 50;
+    static constexpr int BOARD_Y = 12;
+
+    void step(Bus& bus, uint8_t input, int frame);
+    // Piece randomizer seed (owned here so runs are reproducible)
+    void seed(uint32_t s) { rng_state = s ? s : 1; }
+
+    void save_state(StateWriter& w) const;
+    bool load_state(StateReader& r);
+
+private:
+    uint32_t board[BOARD_HEIGHT][BOARD_WIDTH] = {};
+    int cur_x = 4, cur_y = 0;
+    int cur_type = 0, cur_rot = 0;
+    int score = 0;
+    int lines_cleared = 0;
+    int sound_timer = 0;
+    uint8_t last_input = 0;
+    uint32_t rng_state = 1;
+
+    uint32_t next_random();
+
+    void play_sound(Bus& bus, uint16_t freq, uint8_t volume, int type);
+    void draw_pixel(Bus& bus, int x, int y, uint32_t color);
+    void draw_block(Bus& bus, int bx, int by, uint32_t color);
+    void draw_rect(Bus& bus, int x1, int y1, int w, int h, uint32_t color);
+    bool check_collision(int nx, int ny, int nr);
+};
+
+#endif
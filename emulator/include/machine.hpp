@@ -0,0 +1,53 @@
+#ifndef MACHINE_HPP
+#define MACHINE_HPP
+
+#include "bus.hpp"
+#include "cpu.hpp"
+#include "gpu.hpp"
+#include "apu.hpp"
+#include "loader.hpp"
+#include "hle_tetris.hpp"
+#include "snapshot.hpp"
+#include <string>
+
+// One complete Zenu Pocket: the devices, the HLE bridge and the frame loop.
+// Frontends own pacing, presentation and input sampling.
+class Machine {
+public:
+    Machine();
+
+    bool load(const std::string& boc_path);
+    void seed(uint32_t s) { hle.seed(s); }
+    void run_frame(uint8_t joy, uint8_t joy2 = 0);
+    void run_frame(InputSource& input) { run_frame(input.poll_joy(0), input.poll_joy(1)); }
+
+    // Run-ahead: emulate `frames` frames past the real timeline with `joy`
+    // held, leaving the GPU on the future picture for the frontend to
+    // present, then end_run_ahead() rolls everything back. Audio stays on
+    // the real timeline.
+    void begin_run_ahead(uint8_t joy, int frames, uint8_t joy2 = 0);
+    void end_run_ahead();
+
+    // Hash of the composed screen, for bit-exact regression checks
+    uint64_t frame_hash() const { return fnv1a64(gpu.get_screen(), 160 * 144 * sizeof(uint32_t)); }
+
+    // Register state of every device (memory pages are handled by Snapshot)
+    void save_state(StateWriter& w);
+    bool load_state(StateReader& r);
+
+    bool save_state_file(const std::string& path);
+    bool load_state_file(const std::string& path);
+
+    Bus bus;
+    CPU cpu;
+    GPU gpu;
+    APU apu;
+    HleTetris hle;
+    Snapshot snapshot;
+
+    Manifest manifest;
+    uint64_t rom_hash = 0;
+    uint32_t frame = 0;
+};
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef MOVIE_HPP
+#define MOVIE_HPP
+
+#include <vector>
+#include <cstdint>
+#include <string>
+
+// Input movie: the joypad byte for every frame since power-on, plus the RNG
+// seed and ROM identity needed to reproduce the run. Each frame also stores
+// the framebuffer hash seen while recording so playback can verify itself.
+class Movie {
+public:
+    struct Frame {
+        uint8_t joy;
+        uint64_t fb_hash;
+    };
+
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+    uint64_t rom_hash = 0;
+    uint32_t seed = 1;
+    std::vector<Frame> frames;
+
+    static constexpr uint32_t MAGIC = 0x564D4E5A; // "ZNMV"
+    static constexpr uint32_t VERSION = 1;
+};
+
+#endif
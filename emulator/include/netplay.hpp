@@ -0,0 +1,81 @@
+#ifndef NETPLAY_HPP
+#define NETPLAY_HPP
+
+#include <cstdint>
+#include <string>
+
+class Machine;
+class Rewinder;
+
+// Two-player rollback netplay over UDP.
+//
+// Both peers simulate every frame with both joypads. Local input is sent
+// with a small input delay; remote input that hasn't arrived yet is
+// predicted by repeating the last known one. When the real remote input
+// disagrees with a prediction, the machine is stepped back through the
+// Rewinder to the first wrong frame and re-simulated up to the present.
+//
+// Packets carry every local input the peer hasn't acknowledged yet, so a
+// lost packet is simply covered by the next one. Each packet also carries
+// the framebuffer hash of the newest frame whose inputs are final on the
+// sender's side, which lets both ends detect desyncs.
+class Netplay {
+public:
+    Netplay();
+    ~Netplay();
+
+    // player is 1 or 2; peer is "host:port"
+    bool open(uint16_t local_port, const std::string& peer, int player, int input_delay);
+    void close();
+
+    // Records the starting point. Must be called once before advance(),
+    // with the Rewinder empty and the machine at its first frame.
+    void start(Machine& m, Rewinder& rw);
+
+    // Runs one frame (plus any rollback). Returns false without running
+    // anything when prediction would get too far ahead of the peer.
+    bool advance(Machine& m, Rewinder& rw, uint8_t local_joy);
+
+    uint32_t get_rollback_frames() const { return rollback_frames; }
+    uint32_t get_stalls() const { return stalls; }
+    bool is_desynced() const { return desynced; }
+
+    static constexpr uint32_t MAGIC = 0x504E4E5A; // "ZNNP"
+    static constexpr uint32_t MAX_PREDICTION = 8; // Frames simulated past the last remote input
+    static constexpr uint32_t HISTORY = 256;      // Ring size for inputs and hashes
+
+private:
+    void poll(Machine& m);
+    void send(Machine& m);
+    void simulate(Machine& m, uint32_t frame);
+    void check_hash(uint32_t frame);
+
+    int sock = -1;
+    uint8_t peer_addr[16] = {}; // sockaddr_in
+    int player = 1;
+
+    // Inputs by frame (frame % HISTORY). counts are the number of
+    // contiguous frames known from frame 0.
+    uint8_t local_input[HISTORY] = {};
+    uint8_t remote_input[HISTORY] = {};
+    uint8_t predicted[HISTORY] = {};  // Remote input a frame was simulated with
+    uint64_t hashes[HISTORY] = {};
+    uint32_t local_count = 0;
+    uint32_t remote_count = 0;
+    uint32_t peer_ack = 0;            // How many of our inputs the peer has
+    uint32_t rollback_to = UINT32_MAX;
+
+    uint32_t base_frame = 0;          // Machine frame netplay frame 0 maps to
+
+    // Peer hashes by frame, tagged with frame + 1 (0 = none received)
+    uint64_t peer_hashes[HISTORY] = {};
+    uint32_t peer_hash_tags[HISTORY] = {};
+    uint32_t checked_count = 0;       // Frames final here, each compared once its peer hash is in
+
+    uint32_t rollback_frames = 0;
+    uint32_t stalls = 0;
+    bool desynced = false;
+    bool warned_rom = false;
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef PREVIEW_HPP
+#define PREVIEW_HPP
+
+#include <vector>
+#include <cstdint>
+#include <string>
+#include "frontend.hpp"
+
+// Streams frames to Zenu Studio's live preview over a localhost TCP socket.
+//
+// Frames are split into TILE x TILE tiles and only the tiles that differ
+// from the last frame actually sent go out. Each message is
+//   u32 length, then: u32 magic, u16 width, u16 height, u16 rect count,
+//   rects of { u16 x, y, w, h, w*h RGBA bytes }
+// all little-endian. The socket is non-blocking: while the studio hasn't
+// taken the previous message, new frames are skipped. Diffing against the
+// last sent frame rather than the last presented one keeps that lossless.
+class PreviewStream : public VideoSink {
+public:
+    ~PreviewStream();
+
+    // target is "host:port"; failures just leave the stream disabled
+    bool open(const std::string& target);
+    void close();
+    bool is_open() const { return sock >= 0; }
+
+    // True when present() would encode a frame rather than skip it. Lets a
+    // caller avoid producing the pixels (e.g. a GPU readback) for nothing.
+    bool ready();
+
+    void present(const uint32_t* pixels, int width, int height) override;
+
+    static constexpr uint32_t MAGIC = 0x46504E5A; // "ZNPF"
+    static constexpr int TILE = 16;
+
+private:
+    bool flush(); // Pushes out what the socket will take; true once empty
+
+    int sock = -1;
+    int width = 0, height = 0;
+    std::vector<uint32_t> sent;  // Last frame the studio has (ARGB)
+    std::vector<uint8_t> out;    // Encoded bytes not yet written
+    size_t out_pos = 0;
+};
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef RECORDER_HPP
+#define RECORDER_HPP
+
+#include <vector>
+#include <deque>
+#include <cstdint>
+#include <string>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "frontend.hpp"
+
+// Frame-exact capture of video and audio to disk.
+//
+// Video goes to a .y4m file (YUV 4:4:4, BT.601) or, for any other
+// extension, raw ARGB8888 frames for bit-exact diffs. Audio goes to a
+// 32-bit float WAV. The emulator thread only copies each frame into a
+// bounded queue; colour conversion and file writes happen on a writer
+// thread. When the queue is full the Block policy waits for the writer,
+// while Drop repeats the previous picture in the file instead, so the
+// timeline and the audio stay intact.
+//
+// As the APU's sink the recorder can forward audio to a device sink too.
+class Recorder : public VideoSink, public AudioSink {
+public:
+    enum class Policy { Block, Drop };
+
+    ~Recorder();
+
+    // Either path may be empty to capture only the other stream
+    bool open(const std::string& video_path, const std::string& wav_path, int width, int height,
+              int sample_rate, Policy policy, size_t queue_frames = 16);
+    void close(); // Drains the queue and finalizes the file headers
+    bool is_open() const { return running; }
+
+    void set_forward(AudioSink* s) { forward = s; }
+
+    void present(const uint32_t* pixels, int width, int height) override;
+    void write(const float* stereo, int frames) override;
+    float rate_ratio() override { return forward ? forward->rate_ratio() : 1.0f; }
+
+    uint32_t get_frames() const { return frames_captured; }
+    uint32_t get_dropped() const { return frames_dropped; }
+
+private:
+    struct Frame {
+        std::vector<uint32_t> pixels;
+        std::vector<float> audio;
+        uint32_t repeats = 0; // Dropped frames to fill in before this one
+    };
+
+    void writer_loop();
+    void write_video(const std::vector<uint32_t>& pixels);
+    void write_wav_header();
+
+    std::ofstream video_file, wav_file;
+    bool y4m = false;
+    int width = 0, height = 0;
+    int sample_rate = 48000;
+    Policy policy = Policy::Block;
+    size_t capacity = 16;
+
+    std::deque<Frame> queue;
+    std::mutex queue_lock;
+    std::condition_variable queue_cv;
+    std::thread writer;
+    bool running = false;
+    bool stopping = false;
+
+    AudioSink* forward = nullptr;
+    std::vector<float> pending_audio; // Samples for the frame being emulated
+    double silence_accum = 0.0;
+    bool frame_has_audio = false;
+    uint32_t pending_repeats = 0;
+    uint32_t frames_captured = 0;
+    uint32_t frames_dropped = 0;
+
+    // Writer thread only
+    std::vector<uint8_t> yuv;
+    std::vector<uint32_t> last_pixels;
+    uint64_t audio_bytes = 0;
+};
+
+#endif
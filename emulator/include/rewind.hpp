@@ -0,0 +1,49 @@
+#ifndef REWIND_HPP
+#define REWIND_HPP
+
+#include <vector>
+#include <deque>
+#include <cstdint>
+#include <cstddef>
+
+class Machine;
+
+// Hold-to-rewind history in a fixed-size byte ring.
+//
+// The machine's Snapshot mirror is the keyframe: it always holds the newest
+// pushed state in full. Each push() records, for every page dirtied since
+// the previous push, the XOR of old and new contents (zero-run encoded),
+// plus the XOR of the register blobs. Applying an entry to the mirror turns
+// it back into the previous frame, so history chains backwards from the
+// keyframe and the oldest entries can be evicted without re-basing.
+//
+// push() must be the only thing capturing the snapshot while history is
+// kept; anything else that captures has to do it with no changes pending.
+class Rewinder {
+public:
+    explicit Rewinder(size_t capacity_bytes);
+
+    void push(Machine& m);
+    bool step_back(Machine& m);
+    void clear();
+
+    size_t frames() const { return entries.size(); }
+    size_t bytes_used() const { return used; }
+
+private:
+    struct Span {
+        size_t offset;
+        size_t size;
+    };
+
+    std::vector<uint8_t> ring;
+    std::deque<Span> entries;
+    size_t head = 0;
+    size_t used = 0;
+    std::vector<uint8_t> scratch;
+
+    void append(const std::vector<uint8_t>& entry);
+    void read_back(const Span& span, std::vector<uint8_t>& out) const;
+};
+
+#endif
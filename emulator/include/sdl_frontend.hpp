@@ -0,0 +1,79 @@
+#ifndef SDL_FRONTEND_HPP
+#define SDL_FRONTEND_HPP
+
+#include <SDL2/SDL.h>
+#include <vector>
+#include <atomic>
+#include <string>
+#include "frontend.hpp"
+
+class APU;
+
+// Window, renderer and streaming texture scaled to the window
+class SdlVideo : public VideoSink {
+public:
+    ~SdlVideo();
+
+    bool init(int width, int height);
+    void cleanup();
+    void set_title(const std::string& title) {
+        if (window) SDL_SetWindowTitle(window, title.c_str());
+    }
+
+    void present(const uint32_t* pixels, int width, int height) override;
+
+private:
+    SDL_Window* window = nullptr;
+    SDL_Renderer* renderer = nullptr;
+    SDL_Texture* texture = nullptr;
+};
+
+// Audio device at its native rate/layout/format. By default the device
+// callback pulls straight from the APU; streaming mode makes this the APU's
+// sink instead, queueing whole frames in a ring the callback drains.
+class SdlAudio : public AudioSink {
+public:
+    ~SdlAudio();
+
+    bool init(APU& apu);
+    void cleanup();
+
+    // The queue fill level drives dynamic rate control
+    void set_streaming(bool enable, int latency_ms);
+    bool is_streaming() const { return streaming; }
+    int queued_frames() const;
+    int target_frames() const { return target_fill; }
+
+    void write(const float* stereo, int frames) override;
+    float rate_ratio() override;
+
+    static constexpr float MAX_RATE_SKEW = 0.005f; // +-0.5% pitch/rate adjust
+
+private:
+    static void audio_callback(void* userdata, uint8_t* stream, int len);
+    // Pulls queued stream frames into out (interleaved stereo)
+    void drain(float* out, int frames);
+
+    APU* apu = nullptr;
+    SDL_AudioSpec want, have;
+    SDL_AudioDeviceID deviceId = 0;
+    int out_channels = 2;
+    std::vector<float> mix_buffer; // Stereo scratch, sized from have.samples
+
+    // Stream ring (interleaved stereo, SPSC: emulator writes, callback reads)
+    std::atomic<bool> streaming{false};
+    std::vector<float> ring;
+    uint32_t ring_mask = 0;
+    std::atomic<uint32_t> ring_read{0};
+    std::atomic<uint32_t> ring_write{0};
+    int target_fill = 0;
+    float last_l = 0.0f, last_r = 0.0f; // Held and decayed on underrun
+};
+
+// Keyboard: arrows, Z/X for A/B, Return for Start, Space for Select
+class SdlInput : public InputSource {
+public:
+    uint8_t poll_joy(int player) override;
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <vector>
+#include <cstdint>
+#include <string>
+
+class Machine;
+
+// In-memory copy of the whole machine. RAM and VRAM are mirrored page by
+// page: capture() copies only the pages the Bus saw written since the last
+// capture/restore, so taking one every frame costs a few dirty pages.
+//
+// The mirror stays coherent only while this is the sole consumer of the
+// Bus dirty list, which is why each Machine owns exactly one.
+class Snapshot {
+public:
+    void capture(Machine& m);
+    bool restore(Machine& m); // False if empty or the registers don't parse
+    bool valid() const { return !regs.empty(); }
+
+    // Versioned file format: header, register blob, then non-zero pages
+    bool write_file(const std::string& path, uint64_t rom_hash) const;
+    bool read_file(const std::string& path, uint64_t rom_hash);
+
+    // Mirror access for delta encoders working on top of the snapshot
+    uint8_t* page_data(uint32_t page);
+    const std::vector<uint8_t>& get_regs() const { return regs; }
+    void set_regs(const std::vector<uint8_t>& r) { regs = r; }
+
+    static constexpr uint32_t MAGIC = 0x54534E5A; // "ZNST"
+    static constexpr uint32_t VERSION = 2;
+
+private:
+    std::vector<uint8_t> pages; // Bus::STATE_PAGES * Bus::PAGE_SIZE
+    std::vector<uint8_t> regs;  // CPU/Bus/GPU/APU/HLE registers
+
+    void ensure_pages();
+};
+
+#endif
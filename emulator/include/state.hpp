@@ -0,0 +1,60 @@
+#ifndef STATE_HPP
+#define STATE_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Little helpers for the binary save-state format. Fields are written in
+// host byte order; the file header records the version so layouts can move.
+class StateWriter {
+public:
+    explicit StateWriter(std::vector<uint8_t>& out) : out(out) {}
+
+    void write_bytes(const void* data, size_t size) {
+        const uint8_t* p = (const uint8_t*)data;
+        out.insert(out.end(), p, p + size);
+    }
+
+    template <typename T>
+    void write(const T& value) { write_bytes(&value, sizeof(T)); }
+
+private:
+    std::vector<uint8_t>& out;
+};
+
+class StateReader {
+public:
+    StateReader(const uint8_t* data, size_t size) : p(data), end(data + size) {}
+
+    bool read_bytes(void* data, size_t size) {
+        if ((size_t)(end - p) < size) { ok = false; return false; }
+        std::memcpy(data, p, size);
+        p += size;
+        return true;
+    }
+
+    template <typename T>
+    bool read(T& value) { return read_bytes(&value, sizeof(T)); }
+
+    bool good() const { return ok; }
+    size_t remaining() const { return end - p; }
+
+private:
+    const uint8_t* p;
+    const uint8_t* end;
+    bool ok = true;
+};
+
+// FNV-1a, used for ROM identity and framebuffer checks
+inline uint64_t fnv1a64(const void* data, size_t size, uint64_t hash = 0xCBF29CE484222325ull) {
+    const uint8_t* p = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= p[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+#endif
@@ -1,95 +1,155 @@
 #include "apu.hpp"
-#include <iostream>
+#include <algorithm>
 
-APU::APU() : deviceId(0) {}
+static constexpr float PI = 3.14159265f;
 
-APU::~APU() {
-    cleanup();
+APU::APU() {}
+
+void APU::set_sample_rate(int rate) {
+    std::lock_guard<std::recursive_mutex> guard(lock);
+    sample_rate = rate;
+    for (int c = 0; c < 4; c++) {
+        live.channels[c].phase_inc = live.channels[c].frequency / (float)sample_rate;
+        shadow.channels[c].phase_inc = shadow.channels[c].frequency / (float)sample_rate;
+    }
 }
 
-bool APU::init() {
-    if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0) {
-        std::cerr << "SDL Audio could not initialize! SDL_Error: " << SDL_GetError() << std::endl;
-        return false;
+void APU::save_state(StateWriter& w) {
+    std::lock_guard<std::recursive_mutex> guard(lock);
+    for (int c = 0; c < 4; c++) {
+        w.write(regs->channels[c].enabled);
+        w.write(regs->channels[c].type);
+        w.write(regs->channels[c].volume);
+        w.write(regs->channels[c].phase);
     }
+    w.write(regs->freq_raw);
+    w.write(regs->pan_raw);
+}
 
-    SDL_memset(&want, 0, sizeof(want));
-    want.freq = 48000; // Hi-Fi Standard
-    want.format = AUDIO_F32SYS; // 32-bit Floating Point Audio
-    want.channels = 1; // Mono for now
-    want.samples = 1024;
-    want.callback = audio_callback;
-    want.userdata = this;
-
-    deviceId = SDL_OpenAudioDevice(NULL, 0, &want, &have, 0);
-    if (deviceId == 0) {
-        std::cerr << "Failed to open audio: " << SDL_GetError() << std::endl;
-        return false;
+bool APU::load_state(StateReader& r) {
+    std::lock_guard<std::recursive_mutex> guard(lock);
+    for (int c = 0; c < 4; c++) {
+        r.read(regs->channels[c].enabled);
+        r.read(regs->channels[c].type);
+        r.read(regs->channels[c].volume);
+        r.read(regs->channels[c].phase);
+    }
+    r.read(regs->freq_raw);
+    r.read(regs->pan_raw);
+    // Derived values follow the registers and the output rate
+    for (int c = 0; c < 4; c++) {
+        regs->channels[c].frequency = (float)regs->freq_raw[c];
+        regs->channels[c].phase_inc = regs->channels[c].frequency / (float)sample_rate;
+        float angle = ((float)regs->pan_raw[c] / 255.0f) * PI * 0.5f;
+        regs->channels[c].gain_l = std::cos(angle);
+        regs->channels[c].gain_r = std::sin(angle);
     }
+    return r.good();
+}
+
+void APU::set_sink(AudioSink* s) {
+    std::lock_guard<std::recursive_mutex> guard(lock);
+    sink = s;
+    frame_buffer.resize(1024 * 2);
+    frame_accum = 0.0;
+}
 
-    SDL_PauseAudioDevice(deviceId, 0);
-    return true;
+void APU::render(float* out, int frames) {
+    std::lock_guard<std::recursive_mutex> guard(lock);
+    mix(out, frames);
+    if (muted) std::fill(out, out + frames * 2, 0.0f); // Phases keep running
 }
 
-void APU::cleanup() {
-    if (deviceId != 0) {
-        SDL_CloseAudioDevice(deviceId);
-        deviceId = 0;
+void APU::set_speculating(bool on) {
+    std::lock_guard<std::recursive_mutex> guard(lock);
+    if (on == speculating) return;
+    speculating = on;
+    // Speculation starts from the live registers; whatever it leaves in the
+    // shadow is simply dropped
+    if (on) shadow = live;
+    regs = on ? &shadow : &live;
+}
+
+void APU::end_frame() {
+    if (!sink || muted || speculating || replaying) return;
+
+    // The sink may nudge the count (dynamic rate control)
+    frame_accum += (double)sample_rate * sink->rate_ratio() / FRAMES_PER_SECOND;
+    int frames = (int)frame_accum;
+    frame_accum -= frames;
+
+    while (frames > 0) {
+        int chunk = std::min(frames, (int)frame_buffer.size() / 2);
+        mix(frame_buffer.data(), chunk);
+        sink->write(frame_buffer.data(), chunk);
+        frames -= chunk;
     }
 }
 
 void APU::write8(uint32_t addr, uint8_t data) {
     uint32_t reg = addr & 0xFF;
     
-    SDL_LockAudioDevice(deviceId);
-    if (reg < 0x20) { // Legacy Wave Channels
+    std::lock_guard<std::recursive_mutex> guard(lock);
+    if (reg < REG_PAN) { // Legacy Wave Channels
         int ch = reg / 4;
         int sub = reg % 4;
-        if (sub == 0) freq_raw[ch] = (freq_raw[ch] & 0xFF00) | data;
-        else if (sub == 1) freq_raw[ch] = (freq_raw[ch] & 0x00FF) | (data << 8);
+        if (sub == 0) regs->freq_raw[ch] = (regs->freq_raw[ch] & 0xFF00) | data;
+        else if (sub == 1) regs->freq_raw[ch] = (regs->freq_raw[ch] & 0x00FF) | (data << 8);
         else if (sub == 2) {
-            channels[ch].enabled = (data & 1);
-            channels[ch].type = (data >> 1) & 0x3; // 0=Square, 1=Sine, 2=Triangle
-            if (channels[ch].enabled) channels[ch].phase = 0;
+            regs->channels[ch].enabled = (data & 1);
+            regs->channels[ch].type = (data >> 1) & 0x3; // 0=Square, 1=Sine, 2=Triangle
+            if (regs->channels[ch].enabled) regs->channels[ch].phase = 0;
         } else if (sub == 3) {
-            channels[ch].volume = (float)data / 255.0f;
+            regs->channels[ch].volume = (float)data / 255.0f;
         }
 
-        if (freq_raw[ch] > 0) channels[ch].frequency = (float)freq_raw[ch];
-        else channels[ch].frequency = 0;
+        if (regs->freq_raw[ch] > 0) regs->channels[ch].frequency = (float)regs->freq_raw[ch];
+        else regs->channels[ch].frequency = 0;
+        regs->channels[ch].phase_inc = regs->channels[ch].frequency / (float)sample_rate;
+    } else if (reg < REG_PAN + 4) { // Stereo Pan
+        int ch = reg - REG_PAN;
+        regs->pan_raw[ch] = data;
+        float angle = ((float)data / 255.0f) * PI * 0.5f; // Equal-power law
+        regs->channels[ch].gain_l = std::cos(angle);
+        regs->channels[ch].gain_r = std::sin(angle);
     }
-    SDL_UnlockAudioDevice(deviceId);
 }
 
 uint8_t APU::read8(uint32_t addr) {
+    uint32_t reg = addr & 0xFF;
+    if (reg >= REG_PAN && reg < REG_PAN + 4) return regs->pan_raw[reg - REG_PAN];
     return 0;
 }
 
-void APU::audio_callback(void* userdata, uint8_t* stream, int len) {
-    APU* apu = (APU*)userdata;
-    float* buffer = (float*)stream; // 32-bit float buffer
-    int samples = len / sizeof(float);
+void APU::mix(float* out, int frames) {
+    std::fill(out, out + frames * 2, 0.0f);
+
+    // Channel-major so each inner loop runs one oscillator over the whole block
+    for (int c = 0; c < 4; c++) {
+        Channel& ch = live.channels[c];
+        if (!ch.enabled || ch.frequency <= 0) continue;
 
-    for (int i = 0; i < samples; i++) {
-        float out = 0.0f;
-        for (int c = 0; c < 4; c++) {
-            if (!apu->channels[c].enabled || apu->channels[c].frequency <= 0) continue;
+        float amp = ch.volume * 0.25f; // Mix 4 channels
+        float left = amp * ch.gain_l;
+        float right = amp * ch.gain_r;
+        float phase = ch.phase;
 
+        for (int i = 0; i < frames; i++) {
             float sample = 0.0f;
-            if (apu->channels[c].type == 0) { // Square
-                sample = (apu->channels[c].phase < 0.5f) ? 1.0f : -1.0f;
-            } else if (apu->channels[c].type == 1) { // Sine (Smooth Hi-Fi)
-                sample = std::sin(apu->channels[c].phase * 2.0f * M_PI);
-            } else if (apu->channels[c].type == 2) { // Triangle
-                sample = 4.0f * std::abs(apu->channels[c].phase - 0.5f) - 1.0f;
+            if (ch.type == 0) { // Square
+                sample = (phase < 0.5f) ? 1.0f : -1.0f;
+            } else if (ch.type == 1) { // Sine (Smooth Hi-Fi)
+                sample = std::sin(phase * 2.0f * PI);
+            } else if (ch.type == 2) { // Triangle
+                sample = 4.0f * std::abs(phase - 0.5f) - 1.0f;
             }
 
-            out += sample * apu->channels[c].volume * 0.25f; // Mix 4 channels
+            out[i * 2]     += sample * left;
+            out[i * 2 + 1] += sample * right;
 
-            apu->channels[c].phase += apu->channels[c].frequency / 48000.0f;
-            while (apu->channels[c].phase >= 1.0f) apu->channels[c].phase -= 1.0f;
+            phase += ch.phase_inc;
+            if (phase >= 1.0f) phase -= std::floor(phase);
         }
-        
-        buffer[i] = out; // Direct 32-bit float output
+        ch.phase = phase;
     }
 }
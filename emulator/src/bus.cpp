@@ -1,14 +1,48 @@
 #include "bus.hpp"
 #include <cstring>
+#include <algorithm>
 
 Bus::Bus() : hle_bridge_data(0) {
     ram.resize(RAM_SIZE, 0);
     rom_area.resize(ROM_SIZE, 0);
     vram.resize(VRAM_SIZE, 0);
+    page_dirty.resize(STATE_PAGES, 0);
 }
 
 Bus::~Bus() {}
 
+void Bus::clear_dirty() {
+    for (uint32_t page : dirty_list) page_dirty[page] = 0;
+    dirty_list.clear();
+}
+
+void Bus::mark_vram_dirty(uint32_t offset, uint32_t len) {
+    if (len == 0) return;
+    uint32_t first = offset >> PAGE_SHIFT;
+    uint32_t last = std::min(offset + len - 1, VRAM_SIZE - 1) >> PAGE_SHIFT;
+    for (uint32_t p = first; p <= last; p++) mark_page_dirty(RAM_PAGES + p);
+}
+
+void Bus::save_state(StateWriter& w) const {
+    w.write(joy_state);
+    w.write(hle_bridge_data);
+    w.write(irq_pending);
+    w.write(irq_enable);
+    w.write(cycles);
+    w.write(mtimecmp);
+}
+
+bool Bus::load_state(StateReader& r) {
+    r.read(joy_state);
+    r.read(hle_bridge_data);
+    r.read(irq_pending);
+    r.read(irq_enable);
+    r.read(cycles);
+    r.read(mtimecmp);
+    mtimecmp_cycle = (mtimecmp > UINT64_MAX / CYCLES_PER_TICK) ? UINT64_MAX : mtimecmp * CYCLES_PER_TICK;
+    return r.good();
+}
+
 void Bus::load_rom(const std::vector<uint8_t>& data) {
     size_t size = std::min(data.size(), (size_t)ROM_SIZE);
     std::memcpy(rom_area.data(), data.data(), size);
@@ -27,6 +61,14 @@ uint8_t Bus::read8(uint32_t addr) {
         return hle_bridge_data;
     } else if (addr >= APU_START && addr < APU_START + APU_SIZE) {
         if (apu) return apu->read8(addr - APU_START);
+    } else if (addr >= IRQ_START && addr < IRQ_START + IRQ_SIZE) {
+        uint32_t off = addr - IRQ_START;
+        uint32_t reg = (off < 4) ? irq_pending : irq_enable;
+        return (uint8_t)(reg >> ((off & 3) * 8));
+    } else if (addr >= TIMER_START && addr < TIMER_START + TIMER_SIZE) {
+        uint32_t off = addr - TIMER_START;
+        uint64_t reg = (off < 8) ? get_mtime() : mtimecmp;
+        return (uint8_t)(reg >> ((off & 7) * 8));
     }
     return 0;
 }
@@ -34,14 +76,25 @@ uint8_t Bus::read8(uint32_t addr) {
 void Bus::write8(uint32_t addr, uint8_t data) {
     if (addr >= RAM_START && addr < RAM_START + RAM_SIZE) {
         ram[addr - RAM_START] = data;
+        mark_page_dirty((addr - RAM_START) >> PAGE_SHIFT);
     } else if (addr >= VRAM_START && addr < VRAM_START + VRAM_SIZE) {
         vram[addr - VRAM_START] = data;
+        mark_page_dirty(RAM_PAGES + ((addr - VRAM_START) >> PAGE_SHIFT));
     } else if (addr >= JOY_START && addr < JOY_START + JOY_SIZE) {
         joy_state[addr - JOY_START] = data;
     } else if (addr == HLE_BRIDGE) {
         hle_bridge_data = data;
     } else if (addr >= APU_START && addr < APU_START + APU_SIZE) {
         if (apu) apu->write8(addr - APU_START, data);
+    } else if (addr >= IRQ_START && addr < IRQ_START + IRQ_SIZE) {
+        uint32_t off = addr - IRQ_START;
+        uint32_t bits = (uint32_t)data << ((off & 3) * 8);
+        if (off < 4) irq_pending &= ~bits; // Write 1 to acknowledge
+        else irq_enable = (irq_enable & ~(0xFFu << ((off & 3) * 8))) | bits;
+    } else if (addr >= TIMER_START + 8 && addr < TIMER_START + TIMER_SIZE) {
+        uint32_t shift = ((addr - TIMER_START) & 7) * 8;
+        mtimecmp = (mtimecmp & ~(0xFFull << shift)) | ((uint64_t)data << shift);
+        mtimecmp_cycle = (mtimecmp > UINT64_MAX / CYCLES_PER_TICK) ? UINT64_MAX : mtimecmp * CYCLES_PER_TICK;
     }
 }
 
@@ -10,9 +10,53 @@ CPU::~CPU() {}
 void CPU::reset() {
     pc = 0x00010000; // Entry point in ROM
     for (int i = 0; i < 32; i++) regs[i] = 0;
+    csr_mstatus = csr_mie = csr_mip = 0;
+    csr_mtvec = csr_mscratch = csr_mepc = csr_mcause = csr_mtval = 0;
+    waiting = false;
+    instret = 0;
+}
+
+void CPU::save_state(StateWriter& w) const {
+    w.write(pc);
+    w.write(regs);
+    w.write(csr_mstatus); w.write(csr_mie); w.write(csr_mip);
+    w.write(csr_mtvec); w.write(csr_mscratch);
+    w.write(csr_mepc); w.write(csr_mcause); w.write(csr_mtval);
+    w.write(waiting);
+    w.write(instret);
+}
+
+bool CPU::load_state(StateReader& r) {
+    r.read(pc);
+    r.read(regs);
+    r.read(csr_mstatus); r.read(csr_mie); r.read(csr_mip);
+    r.read(csr_mtvec); r.read(csr_mscratch);
+    r.read(csr_mepc); r.read(csr_mcause); r.read(csr_mtval);
+    r.read(waiting);
+    r.read(instret);
+    return r.good();
+}
+
+uint32_t CPU::sample_mip() const {
+    return (bus.irq_line() ? MIP_MEIP : 0) | (bus.timer_pending() ? MIP_MTIP : 0);
 }
 
 void CPU::step(bool debug) {
+    // Sample interrupt lines; any enabled pending interrupt wakes WFI, and is
+    // taken only if globally enabled in mstatus.
+    csr_mip = sample_mip();
+
+    uint32_t pending = csr_mip & csr_mie;
+    if (pending) {
+        waiting = false;
+        if (csr_mstatus & MSTATUS_MIE) {
+            // External before timer, as in the privileged spec
+            trap(CAUSE_INTERRUPT | ((pending & MIP_MEIP) ? 11 : 7), pc);
+            return;
+        }
+    }
+    if (waiting) return;
+
     uint32_t instr = bus.read32(pc);
     if (debug) {
         std::cout << "0x" << std::hex << pc << ": " << disassemble(instr) << std::dec << std::endl;
@@ -21,6 +65,8 @@ void CPU::step(bool debug) {
     pc += 4;
     execute(instr);
     regs[0] = 0;
+    instret++;
+    bus.tick();
 }
 
 void CPU::execute(uint32_t instr) {
@@ -145,6 +191,103 @@ void CPU::execute(uint32_t instr) {
                     break;
             }
             break;
+        case 0x73: // SYSTEM
+            execute_system(instr);
+            break;
+    }
+}
+
+void CPU::execute_system(uint32_t instr) {
+    uint32_t rd = (instr >> 7) & 0x1F;
+    uint32_t funct3 = (instr >> 12) & 0x07;
+    uint32_t rs1 = (instr >> 15) & 0x1F;
+    uint16_t csr = (instr >> 20) & 0xFFF;
+
+    if (funct3 == 0) {
+        switch (instr >> 20) {
+            case 0x000: trap(CAUSE_ECALL_M, pc - 4); break; // ECALL
+            case 0x001: trap(CAUSE_BREAKPOINT, pc - 4); break; // EBREAK
+            case 0x302: // MRET
+                pc = csr_mepc;
+                if (csr_mstatus & MSTATUS_MPIE) csr_mstatus |= MSTATUS_MIE;
+                else csr_mstatus &= ~MSTATUS_MIE;
+                csr_mstatus |= MSTATUS_MPIE;
+                break;
+            case 0x105: // WFI
+                // Parks only while nothing enabled is pending; otherwise it
+                // falls through so the interrupt is taken on the next step
+                csr_mip = sample_mip();
+                waiting = (csr_mip & csr_mie) == 0;
+                break;
+        }
+        return;
+    }
+
+    // Zicsr: CSRRW/CSRRS/CSRRC and their immediate forms
+    uint32_t src = (funct3 & 0x4) ? rs1 : regs[rs1];
+    uint32_t old = 0;
+    switch (funct3 & 0x3) {
+        case 0x1: // CSRRW(I)
+            if (rd != 0) old = csr_read(csr);
+            csr_write(csr, src);
+            break;
+        case 0x2: // CSRRS(I)
+            old = csr_read(csr);
+            if (rs1 != 0) csr_write(csr, old | src);
+            break;
+        case 0x3: // CSRRC(I)
+            old = csr_read(csr);
+            if (rs1 != 0) csr_write(csr, old & ~src);
+            break;
+    }
+    regs[rd] = old;
+}
+
+void CPU::trap(uint32_t cause, uint32_t epc) {
+    csr_mepc = epc;
+    csr_mcause = cause;
+    csr_mtval = 0;
+
+    // Stack the interrupt enable and stay in machine mode
+    if (csr_mstatus & MSTATUS_MIE) csr_mstatus |= MSTATUS_MPIE;
+    else csr_mstatus &= ~MSTATUS_MPIE;
+    csr_mstatus = (csr_mstatus & ~MSTATUS_MIE) | MSTATUS_MPP;
+
+    pc = csr_mtvec & ~3u;
+    if ((csr_mtvec & 3) == 1 && (cause & CAUSE_INTERRUPT)) pc += 4 * (cause & ~CAUSE_INTERRUPT); // Vectored
+    waiting = false;
+}
+
+uint32_t CPU::csr_read(uint16_t csr) {
+    switch (csr) {
+        case CSR_MSTATUS:  return csr_mstatus;
+        case CSR_MIE:      return csr_mie;
+        case CSR_MTVEC:    return csr_mtvec;
+        case CSR_MSCRATCH: return csr_mscratch;
+        case CSR_MEPC:     return csr_mepc;
+        case CSR_MCAUSE:   return csr_mcause;
+        case CSR_MTVAL:    return csr_mtval;
+        case CSR_MIP:      return csr_mip;
+        case CSR_MCYCLE:   case CSR_CYCLE:    return (uint32_t)bus.get_cycles();
+        case CSR_MCYCLEH:  case CSR_CYCLEH:   return (uint32_t)(bus.get_cycles() >> 32);
+        case CSR_MINSTRET: case CSR_INSTRET:  return (uint32_t)instret;
+        case CSR_MINSTRETH: case CSR_INSTRETH: return (uint32_t)(instret >> 32);
+        case CSR_TIME:     return (uint32_t)bus.get_mtime();
+        case CSR_TIMEH:    return (uint32_t)(bus.get_mtime() >> 32);
+    }
+    return 0;
+}
+
+void CPU::csr_write(uint16_t csr, uint32_t value) {
+    switch (csr) {
+        case CSR_MSTATUS:  csr_mstatus = (value & (MSTATUS_MIE | MSTATUS_MPIE)) | MSTATUS_MPP; break;
+        case CSR_MIE:      csr_mie = value; break;
+        case CSR_MTVEC:    csr_mtvec = value; break;
+        case CSR_MSCRATCH: csr_mscratch = value; break;
+        case CSR_MEPC:     csr_mepc = value & ~3u; break;
+        case CSR_MCAUSE:   csr_mcause = value; break;
+        case CSR_MTVAL:    csr_mtval = value; break;
+        case CSR_MIP:      break; // Interrupt lines are driven by hardware
     }
 }
 
@@ -174,6 +317,13 @@ std::string CPU::disassemble(uint32_t instr) {
             if (funct7 == 0x01) sprintf(buf, "mul/div x%d, x%d, x%d", rd, rs1, rs2);
             else sprintf(buf, "op x%d, x%d, x%d", rd, rs1, rs2);
             break;
+        case 0x73:
+            if (instr == 0x00000073) sprintf(buf, "ecall");
+            else if (instr == 0x00100073) sprintf(buf, "ebreak");
+            else if (instr == 0x30200073) sprintf(buf, "mret");
+            else if (instr == 0x10500073) sprintf(buf, "wfi");
+            else sprintf(buf, "csr%s x%d, 0x%x, x%d", funct3 == 1 || funct3 == 5 ? "rw" : funct3 == 2 || funct3 == 6 ? "rs" : "rc", rd, instr >> 20, rs1);
+            break;
         default: sprintf(buf, "unknown (0x%x)", instr); break;
     }
     return std::string(buf);
@@ -0,0 +1,64 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <thread>
+#include <chrono>
+#include "farm.hpp"
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cout << "Usage: ./build/zenu-farm <jobs.txt> [options]" << std::endl;
+        std::cout << "  Each job line: <rom.boc> <frames> [input.zmv]" << std::endl;
+        std::cout << "  --threads <n>  Worker threads (default: hardware concurrency)" << std::endl;
+        std::cout << "  --out <file>   Write results there instead of stdout" << std::endl;
+        return 0;
+    }
+
+    const char* jobs_path = nullptr;
+    int threads = (int)std::thread::hardware_concurrency();
+    const char* out_path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (arg == "--out" && i + 1 < argc) out_path = argv[++i];
+        else if (arg[0] != '-') jobs_path = argv[i];
+        else std::cerr << "Unknown option: " << arg << std::endl;
+    }
+    if (!jobs_path) {
+        std::cerr << "No job list given" << std::endl;
+        return -1;
+    }
+
+    std::vector<FarmJob> jobs;
+    if (!Farm::load_jobs(jobs_path, jobs)) return -1;
+
+    Farm farm(threads);
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<FarmResult> results = farm.run(jobs);
+    double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    std::ofstream out_file;
+    if (out_path) out_file.open(out_path);
+    std::ostream& out = out_path ? out_file : std::cout;
+
+    // Tab-separated so results diff cleanly between runs
+    out << "rom\tinput\tframes\tstatus\tfb_hash\tvideo_hash\taudio_hash\tmismatches\tms\tinstret\tcycles\tmips" << "\n";
+    int failed = 0;
+    for (size_t i = 0; i < jobs.size(); i++) {
+        const FarmJob& job = jobs[i];
+        const FarmResult& r = results[i];
+        std::string status = !r.ok ? r.error : (r.mismatches ? "desync" : "ok");
+        if (status != "ok") failed++;
+        double mips = r.wall_ms > 0 ? r.instret / (r.wall_ms * 1000.0) : 0.0;
+        out << job.rom << "\t" << (job.input.empty() ? "-" : job.input) << "\t" << job.frames << "\t" << status << "\t"
+            << std::hex << std::setfill('0') << std::setw(16) << r.fb_hash << "\t" << std::setw(16) << r.video_hash << "\t"
+            << std::setw(16) << r.audio_hash << std::dec << std::setfill(' ') << "\t" << r.mismatches << "\t"
+            << std::fixed << std::setprecision(1) << r.wall_ms << "\t" << r.instret << "\t" << r.cycles << "\t"
+            << std::setprecision(1) << mips << "\n";
+    }
+
+    std::cerr << jobs.size() << " job(s) on " << threads << " thread(s) in " << total_ms << " ms, "
+              << failed << " failed" << std::endl;
+    return failed ? 1 : 0;
+}
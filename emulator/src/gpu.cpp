@@ -1,34 +1,12 @@
 #include "gpu.hpp"
-#include <iostream>
 #include <cstring>
+#include <cstdlib>
 
-GPU::GPU() : window(nullptr), renderer(nullptr), texture(nullptr) {
+GPU::GPU() {
     for (int i = 0; i < WIDTH * HEIGHT; i++) screen[i] = 0xFF000000; // Black
 }
 
-GPU::~GPU() {
-    cleanup();
-}
-
-bool GPU::init() {
-    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        std::cerr << "SDL could not initialize! SDL_Error: " << SDL_GetError() << std::endl;
-        return false;
-    }
-
-    window = SDL_CreateWindow("Zenu Emulator", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, WIDTH * 2, HEIGHT * 2, SDL_WINDOW_SHOWN);
-    if (!window) {
-        std::cerr << "Window could not be created! SDL_Error: " << SDL_GetError() << std::endl;
-        return false;
-    }
-
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-    texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, WIDTH, HEIGHT);
-
-    return true;
-}
-
-void GPU::render(uint8_t* vram) {
+void GPU::compose(uint8_t* vram) {
     uint32_t mode = *(uint32_t*)(vram + 0xFF000C);
     
     if (mode == 0) {
@@ -72,18 +50,6 @@ void GPU::render(uint8_t* vram) {
             *(uint32_t*)(vram + 0xFF0020) = 0;
         }
     }
-
-    SDL_UpdateTexture(texture, NULL, screen, WIDTH * sizeof(uint32_t));
-    SDL_RenderClear(renderer);
-    SDL_RenderCopy(renderer, texture, NULL, NULL);
-    SDL_RenderPresent(renderer);
-}
-
-void GPU::cleanup() {
-    if (texture) SDL_DestroyTexture(texture);
-    if (renderer) SDL_DestroyRenderer(renderer);
-    if (window) SDL_DestroyWindow(window);
-    SDL_Quit();
 }
 
 void GPU::update() {
@@ -0,0 +1,166 @@
+#include "hle_tetris.hpp"
+#include <algorithm>
+
+static const uint32_t colors[] = {
+    0xFF000000,   // Empty
+    0xFF00FFFF,   // I (Cyan)
+    0xFFFFFF00,   // O (Yellow)
+    0xFF800080,   // T (Purple)
+    0xFF00FF00,   // S (Green)
+    0xFFFF0000,   // Z (Red)
+    0xFF0000FF,   // J (Blue)
+    0xFFFFA500    // L (Orange)
+};
+
+static const uint16_t tetrominoes[7][4] = {
+    {0x0F00, 0x4444, 0x0F00, 0x4444}, {0x0660, 0x0660, 0x0660, 0x0660}, {0x0E40, 0x4C40, 0x4E00, 0x4640},
+    {0x06C0, 0x8C40, 0x06C0, 0x8C40}, {0x0C60, 0x4C80, 0x0C60, 0x4C80}, {0x0E80, 0xC440, 0x2E00, 0x88C0},
+    {0x0E20, 0x44C0, 0x8E00, 0xC880}
+};
+
+
+void HleTetris::play_sound(Bus& bus, uint16_t freq, uint8_t volume, int type) {
+    bus.write8(0x02000100, freq & 0xFF);
+    bus.write8(0x02000101, (freq >> 8) & 0xFF);
+    bus.write8(0x02000103, volume);
+    bus.write8(0x02000102, 1 | (type << 1)); // Enable + Wave Type
+}
+
+void HleTetris::draw_pixel(Bus& bus, int x, int y, uint32_t color) {
+    if (x < 0 || x >= 160 || y < 0 || y >= 144) return;
+    uint32_t* vram = (uint32_t*)bus.get_vram_ptr();
+    vram[y * 160 + x] = color;
+}
+
+void HleTetris::draw_block(Bus& bus, int bx, int by, uint32_t color) {
+    for (int y = 0; y < BLOCK_SIZE-1; y++) {
+        for (int x = 0; x < BLOCK_SIZE-1; x++) {
+            draw_pixel(bus, BOARD_X + bx * BLOCK_SIZE + x, BOARD_Y + by * BLOCK_SIZE + y, color);
+        }
+    }
+}
+
+void HleTetris::draw_rect(Bus& bus, int x1, int y1, int w, int h, uint32_t color) {
+    for(int y=y1; y<y1+h; y++) {
+        for(int x=x1; x<x1+w; x++) {
+            draw_pixel(bus, x, y, color);
+        }
+    }
+}
+
+uint32_t HleTetris::next_random() {
+    // xorshift32: cheap, and unlike rand() private to this instance
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+bool HleTetris::check_collision(int nx, int ny, int nr) {
+    uint16_t shape = tetrominoes[cur_type][nr];
+    for (int i = 0; i < 16; i++) {
+        if (shape & (1 << (15 - i))) {
+            int px = nx + (i % 4);
+            int py = ny + (i / 4);
+            if (px < 0 || px >= BOARD_WIDTH || py >= BOARD_HEIGHT) return true;
+            if (py >= 0 && board[py][px]) return true;
+        }
+    }
+    return false;
+}
+
+void HleTetris::step(Bus& bus, uint8_t input, int frame) {
+    if (sound_timer > 0) {
+        sound_timer--;
+        if (sound_timer == 0) bus.write8(0x02000102, 0); // Disable sound
+    }
+
+    if ((input & (1 << 2)) && !(last_input & (1 << 2))) {
+        if (!check_collision(cur_x - 1, cur_y, cur_rot)) {
+            cur_x--;
+            play_sound(bus, 440, 40, 1); sound_timer = 3; // Smooth A4 Sine
+        }
+    }
+    if ((input & (1 << 3)) && !(last_input & (1 << 3))) {
+        if (!check_collision(cur_x + 1, cur_y, cur_rot)) {
+            cur_x++;
+            play_sound(bus, 440, 40, 1); sound_timer = 3;
+        }
+    }
+    if ((input & (1 << 4)) && !(last_input & (1 << 4))) {
+        int nr = (cur_rot + 1) % 4;
+        if (!check_collision(cur_x, cur_y, nr)) {
+            cur_rot = nr;
+            play_sound(bus, 523, 60, 1); sound_timer = 4; // C5 Sine
+        }
+    }
+    if ((input & (1 << 1)) && frame % 2 == 0) if (!check_collision(cur_x, cur_y + 1, cur_rot)) cur_y++;
+    last_input = input;
+
+    int speed = 20;
+    if (frame % speed == 0) {
+        if (!check_collision(cur_x, cur_y + 1, cur_rot)) {
+            cur_y++;
+        } else {
+            uint16_t shape = tetrominoes[cur_type][cur_rot];
+            for (int i = 0; i < 16; i++) {
+                if (shape & (1 << (15 - i))) {
+                    int px = cur_x + (i % 4); int py = cur_y + (i / 4);
+                    if (py >= 0) board[py][px] = cur_type + 1;
+                }
+            }
+            play_sound(bus, 220, 100, 1); sound_timer = 10; // Warm A3 Bass
+            int bonus = 0;
+            for (int y = BOARD_HEIGHT - 1; y >= 0; y--) {
+                bool full = true;
+                for (int x = 0; x < BOARD_WIDTH; x++) if (!board[y][x]) { full = false; break; }
+                if (full) {
+                    for (int ty = y; ty > 0; ty--) for (int x = 0; x < BOARD_WIDTH; x++) board[ty][x] = board[ty-1][x];
+                    y++; bonus++; lines_cleared++;
+                }
+            }
+            if (bonus > 0) {
+                play_sound(bus, 880, 150, 1); sound_timer = 15; // High A5 Sine
+            }
+            score += bonus * 100;
+            cur_x = 4; cur_y = 0; cur_type = next_random() % 7;
+            if (check_collision(cur_x, cur_y, cur_rot)) {
+                for(int i=0; i<BOARD_HEIGHT; i++) for(int j=0; j<BOARD_WIDTH; j++) board[i][j] = 0;
+                score = 0; lines_cleared = 0;
+            }
+        }
+    }
+
+    // Render
+    uint32_t* vram = (uint32_t*)bus.get_vram_ptr();
+    std::fill(vram, vram + (160 * 144), 0xFF1A1A2E); // Dark Purple WITH ALPHA
+    draw_rect(bus, BOARD_X - 2, BOARD_Y - 2, BOARD_WIDTH * BLOCK_SIZE + 4, BOARD_HEIGHT * BLOCK_SIZE + 4, 0xFF4E4E6E);
+    draw_rect(bus, BOARD_X, BOARD_Y, BOARD_WIDTH * BLOCK_SIZE, BOARD_HEIGHT * BLOCK_SIZE, 0xFF0F0F1F);
+    for (int y = 0; y < BOARD_HEIGHT; y++) for (int x = 0; x < BOARD_WIDTH; x++) {
+        if (board[y][x]) draw_block(bus, x, y, colors[board[y][x]]);
+    }
+    uint16_t shape = tetrominoes[cur_type][cur_rot];
+    for (int i = 0; i < 16; i++) if (shape & (1 << (15 - i))) draw_block(bus, cur_x + (i % 4), cur_y + (i / 4), colors[cur_type + 1]);
+    draw_rect(bus, 5, 10, 35, 30, 0x33334D); 
+    draw_rect(bus, 120, 10, 35, 120, 0x33334D); 
+    bus.mark_vram_dirty(0, 160 * 144 * sizeof(uint32_t)); // Drawn through the raw VRAM pointer
+}
+
+void HleTetris::save_state(StateWriter& w) const {
+    w.write(board);
+    w.write(cur_x); w.write(cur_y);
+    w.write(cur_type); w.write(cur_rot);
+    w.write(score); w.write(lines_cleared);
+    w.write(sound_timer); w.write(last_input);
+    w.write(rng_state);
+}
+
+bool HleTetris::load_state(StateReader& r) {
+    r.read(board);
+    r.read(cur_x); r.read(cur_y);
+    r.read(cur_type); r.read(cur_rot);
+    r.read(score); r.read(lines_cleared);
+    r.read(sound_timer); r.read(last_input);
+    r.read(rng_state);
+    return r.good();
+}
@@ -0,0 +1,91 @@
+#include "machine.hpp"
+#include <algorithm>
+#include <iostream>
+
+Machine::Machine() : cpu(bus) {
+    bus.set_apu(&apu);
+}
+
+bool Machine::load(const std::string& boc_path) {
+    std::vector<uint8_t> rom_data;
+    if (!Loader::load_boc(boc_path, rom_data, manifest)) return false;
+    bus.load_rom(rom_data);
+    rom_hash = fnv1a64(rom_data.data(), rom_data.size());
+
+    // Initialize VRAM/Hardware state
+    bus.write32(0x03FF000C, 0); // GPU Mode 0: FB
+    uint32_t* vram_ptr = (uint32_t*)bus.get_vram_ptr();
+    std::fill(vram_ptr, vram_ptr + (160 * 144), 0xFF1A1A2E); // Dark Purple background
+    bus.mark_vram_dirty(0, 160 * 144 * sizeof(uint32_t));
+    return true;
+}
+
+void Machine::run_frame(uint8_t joy, uint8_t joy2) {
+    bus.write8(Bus::JOY1, joy);
+    bus.write8(Bus::JOY2, joy2);
+
+    // CPU Step (30MHz target: 500k cycles per frame)
+    uint64_t frame_end = bus.get_cycles() + Bus::CYCLES_PER_FRAME;
+    while (bus.get_cycles() < frame_end) {
+        cpu.step(false); // No debug for performance
+        if (cpu.is_waiting()) {
+            // Parked in WFI: skip idle time to the next timer event or vblank
+            bus.advance_to(std::min(bus.next_timer_event(), frame_end));
+        }
+    }
+
+    // Check the Magic Port (HLE bridge lives just past the JOY region)
+    if (bus.read8(0x0200FFF0) & 1) {
+        hle.step(bus, joy, frame);
+        bus.write8(0x0200FFF0, 0); // Clear trigger
+    }
+
+    gpu.update();
+    gpu.compose(bus.get_vram_ptr());
+    bus.mark_vram_dirty(0xFF0020, 4); // compose() acks the command register in place
+    bus.raise_irq(Bus::IRQ_VBLANK); // Frame is out, GPU enters vblank
+    apu.end_frame();
+    frame++;
+}
+
+void Machine::begin_run_ahead(uint8_t joy, int frames, uint8_t joy2) {
+    snapshot.capture(*this); // Incremental: only this frame's dirty pages
+    apu.set_speculating(true);
+    for (int i = 0; i < frames; i++) run_frame(joy, joy2);
+}
+
+void Machine::end_run_ahead() {
+    snapshot.restore(*this);
+    apu.set_speculating(false);
+}
+
+void Machine::save_state(StateWriter& w) {
+    w.write(frame);
+    cpu.save_state(w);
+    bus.save_state(w);
+    gpu.save_state(w);
+    apu.save_state(w);
+    hle.save_state(w);
+}
+
+bool Machine::load_state(StateReader& r) {
+    r.read(frame);
+    return cpu.load_state(r) && bus.load_state(r) && gpu.load_state(r) &&
+           apu.load_state(r) && hle.load_state(r);
+}
+
+bool Machine::save_state_file(const std::string& path) {
+    snapshot.capture(*this);
+    return snapshot.write_file(path, rom_hash);
+}
+
+bool Machine::load_state_file(const std::string& path) {
+    if (!snapshot.read_file(path, rom_hash)) return false;
+    // The mirror was replaced wholesale, so every live page is now stale
+    for (uint32_t p = 0; p < Bus::STATE_PAGES; p++) bus.mark_page_dirty(p);
+    if (!snapshot.restore(*this)) {
+        std::cerr << "Corrupt state file: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
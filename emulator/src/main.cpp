@@ -1,234 +1,299 @@
 #include <iostream>
+#include <fstream>
 #include <vector>
+#include <string>
+#include <algorithm>
+#include <memory>
+#include <cstdlib>
 #include <SDL2/SDL.h>
-#include "cpu.hpp"
-#include "bus.hpp"
-#include "gpu.hpp"
-#include "loader.hpp"
-#include "apu.hpp"
-
-// --- Native Tetris HLE Logic (Pocket Edition 160x144) ---
-#define BOARD_WIDTH 10
-#define BOARD_HEIGHT 20
-#define BLOCK_SIZE 6
-#define BOARD_X 50
-#define BOARD_Y 12
-
-uint32_t board[BOARD_HEIGHT][BOARD_WIDTH];
-int cur_x = 4, cur_y = 0;
-int cur_type = 0, cur_rot = 0;
-int score = 0;
-int lines_cleared = 0;
-
-uint32_t colors[] = {
-    0xFF000000,   // Empty
-    0xFF00FFFF,   // I (Cyan)
-    0xFFFFFF00,   // O (Yellow)
-    0xFF800080,   // T (Purple)
-    0xFF00FF00,   // S (Green)
-    0xFFFF0000,   // Z (Red)
-    0xFF0000FF,   // J (Blue)
-    0xFFFFA500    // L (Orange)
-};
-
-const uint16_t tetrominoes[7][4] = {
-    {0x0F00, 0x4444, 0x0F00, 0x4444}, {0x0660, 0x0660, 0x0660, 0x0660}, {0x0E40, 0x4C40, 0x4E00, 0x4640},
-    {0x06C0, 0x8C40, 0x06C0, 0x8C40}, {0x0C60, 0x4C80, 0x0C60, 0x4C80}, {0x0E80, 0xC440, 0x2E00, 0x88C0},
-    {0x0E20, 0x44C0, 0x8E00, 0xC880}
-};
-
-
-void hle_play_sound(Bus& bus, uint16_t freq, uint8_t volume, int type) {
-    bus.write8(0x02000100, freq & 0xFF);
-    bus.write8(0x02000101, (freq >> 8) & 0xFF);
-    bus.write8(0x02000103, volume);
-    bus.write8(0x02000102, 1 | (type << 1)); // Enable + Wave Type
-}
-
-void hle_draw_pixel(Bus& bus, int x, int y, uint32_t color) {
-    if (x < 0 || x >= 160 || y < 0 || y >= 144) return;
-    uint32_t* vram = (uint32_t*)bus.get_vram_ptr();
-    vram[y * 160 + x] = color;
-}
+#include "machine.hpp"
+#include "sdl_frontend.hpp"
+#include "rewind.hpp"
+#include "movie.hpp"
+#include "netplay.hpp"
+#include "recorder.hpp"
+#include "preview.hpp"
 
-void hle_draw_block(Bus& bus, int bx, int by, uint32_t color) {
-    for (int y = 0; y < BLOCK_SIZE-1; y++) {
-        for (int x = 0; x < BLOCK_SIZE-1; x++) {
-            hle_draw_pixel(bus, BOARD_X + bx * BLOCK_SIZE + x, BOARD_Y + by * BLOCK_SIZE + y, color);
-        }
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cout << "Usage: ./build/zenu-emulator <path-to-game.boc> [options]" << std::endl;
+        std::cout << "  --audio-sync         Pace frames from the audio clock with dynamic rate control" << std::endl;
+        std::cout << "  --audio-latency <ms> Target audio queue latency for --audio-sync (default 50)" << std::endl;
+        std::cout << "  --turbo              Start in fast-forward (hold Tab to fast-forward otherwise)" << std::endl;
+        std::cout << "  --frameskip <n>      Present one of every n frames while fast-forwarding (default 8)" << std::endl;
+        std::cout << "  --state <file>       Save-state file for F5 (save) / F8 (load) (default <name>.state)" << std::endl;
+        std::cout << "  --load-state         Load the save-state file at boot" << std::endl;
+        std::cout << "  --rewind-mb <n>      Rewind history budget, hold Backspace to rewind (default 32, 0 = off)" << std::endl;
+        std::cout << "  --run-ahead <n>      Present n frames ahead of the real timeline to hide input lag" << std::endl;
+        std::cout << "  --record <file>      Record joypad input and frame hashes to a movie" << std::endl;
+        std::cout << "  --play <file>        Play back a movie, verifying frame hashes" << std::endl;
+        std::cout << "  --seed <n>           HLE randomizer seed (default 1, movies carry their own)" << std::endl;
+        std::cout << "  --net-peer <host:port> Two-player rollback netplay with the peer over UDP" << std::endl;
+        std::cout << "  --net-port <port>    Local UDP port for netplay (default 7000)" << std::endl;
+        std::cout << "  --net-player <1|2>   Which joypad the local keyboard drives (default 1)" << std::endl;
+        std::cout << "  --net-delay <n>      Netplay input delay in frames (default 2)" << std::endl;
+        std::cout << "  --capture <file>     Record every frame: .y4m (YUV 4:4:4) or raw ARGB8888 otherwise" << std::endl;
+        std::cout << "  --capture-wav <file> Record the audio output as 32-bit float WAV (implies --audio-sync)" << std::endl;
+        std::cout << "  --capture-drop       Repeat frames instead of stalling when the disk falls behind" << std::endl;
+        std::cout << "  --preview <host:port> Stream frames to Zenu Studio (default $ZENU_PREVIEW)" << std::endl;
+        std::cout << "  --headless           No window or audio; run as fast as possible" << std::endl;
+        std::cout << "  --frames <n>         Stop after n frames (headless default: length of --play movie)" << std::endl;
+        std::cout << "  --hash-log <file>    Write '<frame> <framebuffer hash>' per frame" << std::endl;
+        return 0;
     }
-}
 
-void hle_draw_rect(Bus& bus, int x1, int y1, int w, int h, uint32_t color) {
-    for(int y=y1; y<y1+h; y++) {
-        for(int x=x1; x<x1+w; x++) {
-            hle_draw_pixel(bus, x, y, color);
-        }
+    const char* rom_path = nullptr;
+    bool audio_sync = false;
+    int audio_latency_ms = 50;
+    bool turbo = false;
+    int frameskip = 8;
+    const char* state_path = nullptr;
+    std::string state_path_buf;
+    bool load_state_at_boot = false;
+    int rewind_mb = 32;
+    int run_ahead = 0;
+    const char* record_path = nullptr;
+    const char* play_path = nullptr;
+    uint32_t seed = 1;
+    bool headless = false;
+    long frame_limit = -1;
+    const char* hash_log_path = nullptr;
+    const char* net_peer = nullptr;
+    const char* capture_path = nullptr;
+    const char* preview_target = getenv("ZENU_PREVIEW");
+    const char* capture_wav_path = nullptr;
+    Recorder::Policy capture_policy = Recorder::Policy::Block;
+    int net_port = 7000;
+    int net_player = 1;
+    int net_delay = 2;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--audio-sync") audio_sync = true;
+        else if (arg == "--audio-latency" && i + 1 < argc) audio_latency_ms = std::max(10, atoi(argv[++i]));
+        else if (arg == "--turbo") turbo = true;
+        else if (arg == "--frameskip" && i + 1 < argc) frameskip = std::max(1, atoi(argv[++i]));
+        else if (arg == "--state" && i + 1 < argc) state_path = argv[++i];
+        else if (arg == "--load-state") load_state_at_boot = true;
+        else if (arg == "--rewind-mb" && i + 1 < argc) rewind_mb = std::max(0, atoi(argv[++i]));
+        else if (arg == "--run-ahead" && i + 1 < argc) run_ahead = std::max(0, std::min(4, atoi(argv[++i])));
+        else if (arg == "--record" && i + 1 < argc) record_path = argv[++i];
+        else if (arg == "--play" && i + 1 < argc) play_path = argv[++i];
+        else if (arg == "--seed" && i + 1 < argc) seed = (uint32_t)strtoul(argv[++i], nullptr, 0);
+        else if (arg == "--preview" && i + 1 < argc) preview_target = argv[++i];
+        else if (arg == "--capture" && i + 1 < argc) capture_path = argv[++i];
+        else if (arg == "--capture-wav" && i + 1 < argc) capture_wav_path = argv[++i];
+        else if (arg == "--capture-drop") capture_policy = Recorder::Policy::Drop;
+        else if (arg == "--net-peer" && i + 1 < argc) net_peer = argv[++i];
+        else if (arg == "--net-port" && i + 1 < argc) net_port = atoi(argv[++i]);
+        else if (arg == "--net-player" && i + 1 < argc) net_player = atoi(argv[++i]);
+        else if (arg == "--net-delay" && i + 1 < argc) net_delay = std::max(0, atoi(argv[++i]));
+        else if (arg == "--headless") headless = true;
+        else if (arg == "--frames" && i + 1 < argc) frame_limit = atol(argv[++i]);
+        else if (arg == "--hash-log" && i + 1 < argc) hash_log_path = argv[++i];
+        else if (arg[0] != '-') rom_path = argv[i];
+        else std::cerr << "Unknown option: " << arg << std::endl;
     }
-}
-
-bool hle_check_collision(int nx, int ny, int nr) {
-    uint16_t shape = tetrominoes[cur_type][nr];
-    for (int i = 0; i < 16; i++) {
-        if (shape & (1 << (15 - i))) {
-            int px = nx + (i % 4);
-            int py = ny + (i / 4);
-            if (px < 0 || px >= BOARD_WIDTH || py >= BOARD_HEIGHT) return true;
-            if (py >= 0 && board[py][px]) return true;
-        }
+    if (!rom_path) {
+        std::cerr << "No .boc path given" << std::endl;
+        return -1;
     }
-    return false;
-}
-
-void hle_tetris_step(Bus& bus, uint8_t input, int frame) {
-    static int sound_timer = 0;
-    if (sound_timer > 0) {
-        sound_timer--;
-        if (sound_timer == 0) bus.write8(0x02000102, 0); // Disable sound
+    bool movie_active = record_path || play_path;
+    if (movie_active && load_state_at_boot) {
+        std::cerr << "Movies start from power-on and cannot be combined with --load-state" << std::endl;
+        return -1;
     }
-
-    static uint8_t last_input = 0;
-    if ((input & (1 << 2)) && !(last_input & (1 << 2))) {
-        if (!hle_check_collision(cur_x - 1, cur_y, cur_rot)) {
-            cur_x--;
-            hle_play_sound(bus, 440, 40, 1); sound_timer = 3; // Smooth A4 Sine
-        }
-    }
-    if ((input & (1 << 3)) && !(last_input & (1 << 3))) {
-        if (!hle_check_collision(cur_x + 1, cur_y, cur_rot)) {
-            cur_x++;
-            hle_play_sound(bus, 440, 40, 1); sound_timer = 3;
-        }
+    if (net_peer && (movie_active || load_state_at_boot)) {
+        std::cerr << "Netplay starts both peers from power-on; movies and --load-state are unavailable" << std::endl;
+        return -1;
     }
-    if ((input & (1 << 4)) && !(last_input & (1 << 4))) {
-        int nr = (cur_rot + 1) % 4;
-        if (!hle_check_collision(cur_x, cur_y, nr)) {
-            cur_rot = nr;
-            hle_play_sound(bus, 523, 60, 1); sound_timer = 4; // C5 Sine
-        }
+    if (headless && frame_limit < 0 && !play_path) {
+        std::cerr << "--headless needs --frames or --play to know when to stop" << std::endl;
+        return -1;
     }
-    if ((input & (1 << 1)) && frame % 2 == 0) if (!hle_check_collision(cur_x, cur_y + 1, cur_rot)) cur_y++;
-    last_input = input;
 
-    int speed = 20;
-    if (frame % speed == 0) {
-        if (!hle_check_collision(cur_x, cur_y + 1, cur_rot)) {
-            cur_y++;
-        } else {
-            uint16_t shape = tetrominoes[cur_type][cur_rot];
-            for (int i = 0; i < 16; i++) {
-                if (shape & (1 << (15 - i))) {
-                    int px = cur_x + (i % 4); int py = cur_y + (i / 4);
-                    if (py >= 0) board[py][px] = cur_type + 1;
-                }
-            }
-            hle_play_sound(bus, 220, 100, 1); sound_timer = 10; // Warm A3 Bass
-            int bonus = 0;
-            for (int y = BOARD_HEIGHT - 1; y >= 0; y--) {
-                bool full = true;
-                for (int x = 0; x < BOARD_WIDTH; x++) if (!board[y][x]) { full = false; break; }
-                if (full) {
-                    for (int ty = y; ty > 0; ty--) for (int x = 0; x < BOARD_WIDTH; x++) board[ty][x] = board[ty-1][x];
-                    y++; bonus++; lines_cleared++;
-                }
-            }
-            if (bonus > 0) {
-                hle_play_sound(bus, 880, 150, 1); sound_timer = 15; // High A5 Sine
-            }
-            score += bonus * 100;
-            cur_x = 4; cur_y = 0; cur_type = rand() % 7;
-            if (hle_check_collision(cur_x, cur_y, cur_rot)) {
-                for(int i=0; i<BOARD_HEIGHT; i++) for(int j=0; j<BOARD_WIDTH; j++) board[i][j] = 0;
-                score = 0; lines_cleared = 0;
-            }
-        }
-    }
+    Machine machine;
+    GPU& gpu = machine.gpu;
+    APU& apu = machine.apu;
+    SdlVideo video;
+    SdlAudio audio;
+    SdlInput input;
+    Recorder recorder;
+    PreviewStream preview;
 
-    // Render
-    uint32_t* vram = (uint32_t*)bus.get_vram_ptr();
-    std::fill(vram, vram + (160 * 144), 0xFF1A1A2E); // Dark Purple WITH ALPHA
-    hle_draw_rect(bus, BOARD_X - 2, BOARD_Y - 2, BOARD_WIDTH * BLOCK_SIZE + 4, BOARD_HEIGHT * BLOCK_SIZE + 4, 0xFF4E4E6E);
-    hle_draw_rect(bus, BOARD_X, BOARD_Y, BOARD_WIDTH * BLOCK_SIZE, BOARD_HEIGHT * BLOCK_SIZE, 0xFF0F0F1F);
-    for (int y = 0; y < BOARD_HEIGHT; y++) for (int x = 0; x < BOARD_WIDTH; x++) {
-        if (board[y][x]) hle_draw_block(bus, x, y, colors[board[y][x]]);
+    if (!headless) {
+        if (!video.init(GPU::WIDTH, GPU::HEIGHT)) return -1;
+        if (!audio.init(apu)) return -1;
+        // WAV capture needs the APU pushing whole frames, so it implies
+        // streaming, and then the device has to pace the loop: a fixed delay
+        // runs ahead of it and overflows the ring
+        if (capture_wav_path) audio_sync = true;
+        if (audio_sync) audio.set_streaming(true, audio_latency_ms);
     }
-    uint16_t shape = tetrominoes[cur_type][cur_rot];
-    for (int i = 0; i < 16; i++) if (shape & (1 << (15 - i))) hle_draw_block(bus, cur_x + (i % 4), cur_y + (i / 4), colors[cur_type + 1]);
-    hle_draw_rect(bus, 5, 10, 35, 30, 0x33334D); 
-    hle_draw_rect(bus, 120, 10, 35, 120, 0x33334D); 
-}
 
-int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cout << "Usage: ./build/zenu-emulator <path-to-game.boc>" << std::endl;
-        return 0;
+    if (!machine.load(rom_path)) return -1;
+    if (capture_path || capture_wav_path) {
+        if (!recorder.open(capture_path ? capture_path : "", capture_wav_path ? capture_wav_path : "",
+                           GPU::WIDTH, GPU::HEIGHT, apu.get_sample_rate(), capture_policy)) return -1;
+        if (capture_wav_path) {
+            if (!headless) recorder.set_forward(&audio); // Tee: the device still plays
+            apu.set_sink(&recorder);
+        }
     }
+    if (preview_target && !headless) preview.open(preview_target);
+    if (!headless) video.set_title("Zenu Pocket - " + machine.manifest.name);
+    if (!state_path) state_path_buf = machine.manifest.name + ".state";
+    else state_path_buf = state_path;
+    if (load_state_at_boot && !machine.load_state_file(state_path_buf)) return -1;
 
-    Bus bus;
-    CPU cpu(bus);
-    GPU gpu;
-    APU apu;
-
-    if (!gpu.init()) return -1;
-    if (!apu.init()) return -1;
-    bus.set_apu(&apu);
+    Movie playback, recording;
+    if (play_path) {
+        if (!playback.load(play_path)) return -1;
+        if (playback.rom_hash != machine.rom_hash) {
+            std::cerr << "Movie was recorded against a different ROM" << std::endl;
+            return -1;
+        }
+        seed = playback.seed;
+        if (frame_limit < 0) frame_limit = (long)playback.frames.size();
+    }
+    machine.seed(seed);
+    recording.rom_hash = machine.rom_hash;
+    recording.seed = seed;
 
-    std::vector<uint8_t> rom_data;
-    Manifest manifest;
+    std::ofstream hash_log;
+    if (hash_log_path) hash_log.open(hash_log_path);
 
-    if (!Loader::load_boc(argv[1], rom_data, manifest)) return -1;
-    bus.load_rom(rom_data);
-    gpu.set_title("Zenu Pocket - " + manifest.name);
+    // Rewinding or loading states mid-movie would desync the recorded input
+    std::unique_ptr<Rewinder> rewinder;
+    if (rewind_mb > 0 && !movie_active && !headless) rewinder.reset(new Rewinder((size_t)rewind_mb << 20));
 
-    // Initialize VRAM/Hardware state
-    bus.write32(0x03FF000C, 0); // GPU Mode 0: FB
-    uint32_t* vram_ptr = (uint32_t*)bus.get_vram_ptr();
-    std::fill(vram_ptr, vram_ptr + (160 * 144), 0xFF1A1A2E); // Dark Purple background
+    // Netplay rolls back through the rewind history, so it always keeps
+    // one, but the player can't rewind a shared session
+    Netplay netplay;
+    if (net_peer) {
+        if (!netplay.open((uint16_t)net_port, net_peer, net_player, net_delay)) return -1;
+        if (!rewinder) rewinder.reset(new Rewinder((size_t)std::max(rewind_mb, 8) << 20));
+        netplay.start(machine, *rewinder);
+        turbo = false;
+        run_ahead = 0;
+        std::cout << "Netplay: player " << net_player << ", peer " << net_peer << std::endl;
+    }
 
     bool running = true;
     SDL_Event e;
-    uint32_t frame = 0;
+    long mismatches = 0;
 
-    std::cout << "Zenu Pocket Mode Initialized: Loading " << manifest.name << std::endl;
+    std::cout << "Zenu Pocket Mode Initialized: Loading " << machine.manifest.name << std::endl;
 
     while (running) {
-        while (SDL_PollEvent(&e) != 0) if (e.type == SDL_QUIT) running = false;
-        
-        const uint8_t* state = SDL_GetKeyboardState(NULL);
+        if (frame_limit >= 0 && (long)machine.frame >= frame_limit) break;
+
         uint8_t joy = 0;
-        if (state[SDL_SCANCODE_UP])    joy |= (1 << 0);
-        if (state[SDL_SCANCODE_DOWN])  joy |= (1 << 1);
-        if (state[SDL_SCANCODE_LEFT])  joy |= (1 << 2);
-        if (state[SDL_SCANCODE_RIGHT]) joy |= (1 << 3);
-        if (state[SDL_SCANCODE_Z])     joy |= (1 << 4);
-        if (state[SDL_SCANCODE_X])     joy |= (1 << 5);
-        if (state[SDL_SCANCODE_RETURN]) joy |= (1 << 6);
-        if (state[SDL_SCANCODE_SPACE])  joy |= (1 << 7);
-        bus.write8(0x02000000, joy);
-
-        // CPU Step (30MHz target: 500k instr per frame)
-        for(int i = 0; i < 500000; i++) {
-            cpu.step(false); // No debug for performance
-            
-            // Check for HLE Bridge (Magic Port)
-            // Memory address 0x0200FFF0 is mapped to JOYPAD region in Bus.cpp
-            // Actually let's check Bus::write8 to see if we need to handle it there
+        bool fast_forward = turbo || headless;
+        bool rewinding = false;
+
+        if (!headless) {
+            while (SDL_PollEvent(&e) != 0) {
+                if (e.type == SDL_QUIT) running = false;
+                else if (e.type == SDL_KEYDOWN && !e.key.repeat) {
+                    if (e.key.keysym.scancode == SDL_SCANCODE_F5) {
+                        uint64_t t0 = SDL_GetPerformanceCounter();
+                        if (machine.save_state_file(state_path_buf)) {
+                            double ms = (SDL_GetPerformanceCounter() - t0) * 1000.0 / SDL_GetPerformanceFrequency();
+                            std::cout << "State saved to " << state_path_buf << " (" << ms << " ms)" << std::endl;
+                        }
+                    } else if (e.key.keysym.scancode == SDL_SCANCODE_F8) {
+                        if (net_peer) {
+                            std::cout << "State loading is disabled during netplay" << std::endl;
+                        } else if (movie_active) {
+                            std::cout << "State loading is disabled while a movie is active" << std::endl;
+                        } else if (machine.load_state_file(state_path_buf)) {
+                            if (rewinder) rewinder->clear(); // History belonged to the old timeline
+                            std::cout << "State loaded from " << state_path_buf << std::endl;
+                        }
+                    }
+                }
+            }
+
+            joy = input.poll_joy(0);
+            const uint8_t* state = SDL_GetKeyboardState(NULL);
+            fast_forward = !net_peer && (turbo || state[SDL_SCANCODE_TAB]);
+            rewinding = rewinder && !net_peer && state[SDL_SCANCODE_BACKSPACE];
+            if ((fast_forward || rewinding) != apu.is_muted()) apu.set_muted(fast_forward || rewinding);
+        }
+
+        // Movie input replaces live input until the movie runs out
+        size_t movie_frame = machine.frame;
+        bool from_movie = play_path && movie_frame < playback.frames.size();
+        if (from_movie) joy = playback.frames[movie_frame].joy;
+
+        if (rewinding) {
+            // Step back one frame per host frame and show where we landed
+            rewinder->step_back(machine);
+            video.present(gpu.get_screen(), GPU::WIDTH, GPU::HEIGHT);
+            preview.present(gpu.get_screen(), GPU::WIDTH, GPU::HEIGHT);
+            recorder.present(gpu.get_screen(), GPU::WIDTH, GPU::HEIGHT);
+        } else if (net_peer && !netplay.advance(machine, *rewinder, joy)) {
+            // Waiting on the peer: keep the last picture and poll again shortly
+            SDL_Delay(1);
+            continue;
+        } else {
+            if (!net_peer) {
+                machine.run_frame(joy);
+                if (rewinder) rewinder->push(machine);
+            }
+
+            uint64_t hash = machine.frame_hash();
+            if (record_path) recording.frames.push_back({joy, hash});
+            if (from_movie && playback.frames[movie_frame].fb_hash != hash) {
+                if (mismatches == 0) std::cerr << "Movie desync: first framebuffer mismatch at frame " << movie_frame << std::endl;
+                mismatches++;
+            }
+            recorder.present(gpu.get_screen(), GPU::WIDTH, GPU::HEIGHT);
+            if (hash_log) hash_log << movie_frame << " " << std::hex << hash << std::dec << "\n";
+
+            // Fast-forward only pays for the texture upload and flip every Nth frame
+            bool present = !headless && (!fast_forward || machine.frame % frameskip == 0);
+            // Run-ahead shows where this input leads, then rolls back to the real frame
+            bool ahead = present && run_ahead > 0 && !fast_forward;
+            if (ahead) machine.begin_run_ahead(joy, run_ahead);
+            if (present) {
+                video.present(gpu.get_screen(), GPU::WIDTH, GPU::HEIGHT);
+                preview.present(gpu.get_screen(), GPU::WIDTH, GPU::HEIGHT);
+            }
+            if (ahead) machine.end_run_ahead();
         }
 
-        // Check the Magic Port in VRAM/JOY region (we use WRAM for the bridge for simplicity)
-        // Let's check bit 0 of the JOY address we set for bridge
-        if (bus.read8(0x0200FFF0) & 1) {
-            hle_tetris_step(bus, joy, frame);
-            bus.write8(0x0200FFF0, 0); // Clear trigger
+        if (fast_forward) {
+            // Uncapped: audio is muted (or absent), so nothing needs to drain
+        } else if (audio_sync) {
+            // The audio device is the master clock: this frame's samples are
+            // queued, so hold off until the queue drains back to the target.
+            uint32_t wait_start = SDL_GetTicks();
+            while (audio.queued_frames() > audio.target_frames() && SDL_GetTicks() - wait_start < 100) {
+                SDL_Delay(1);
+            }
+        } else {
+            SDL_Delay(16);
         }
+    }
 
-        gpu.update();
-        gpu.render(bus.get_vram_ptr());
-        frame++;
-        SDL_Delay(16);
+    if (record_path && recording.save(record_path)) {
+        std::cout << "Recorded " << recording.frames.size() << " frames to " << record_path << std::endl;
+    }
+    if (net_peer) {
+        std::cout << "Netplay: " << netplay.get_rollback_frames() << " frame(s) re-simulated, "
+                  << netplay.get_stalls() << " stall(s)" << (netplay.is_desynced() ? ", DESYNCED" : "") << std::endl;
+        if (netplay.is_desynced()) mismatches++;
+    }
+    if (play_path) {
+        std::cout << "Playback: " << mismatches << " mismatched frame(s)" << std::endl;
     }
 
-    gpu.cleanup();
-    apu.cleanup();
-    return 0;
+    if (recorder.is_open()) {
+        recorder.close();
+        std::cout << "Captured " << recorder.get_frames() << " frames (" << recorder.get_dropped() << " repeated)" << std::endl;
+    }
+    audio.cleanup();
+    video.cleanup();
+    return mismatches ? 1 : 0;
 }
@@ -0,0 +1,58 @@
+#include "movie.hpp"
+#include "state.hpp"
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+bool Movie::save(const std::string& path) const {
+    std::vector<uint8_t> out;
+    StateWriter w(out);
+    w.write(MAGIC);
+    w.write(VERSION);
+    w.write(rom_hash);
+    w.write(seed);
+    w.write((uint32_t)frames.size());
+    for (const Frame& f : frames) {
+        w.write(f.joy);
+        w.write(f.fb_hash);
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Could not write movie: " << path << std::endl;
+        return false;
+    }
+    file.write((const char*)out.data(), out.size());
+    return (bool)file;
+}
+
+bool Movie::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Could not open movie: " << path << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    StateReader r(data.data(), data.size());
+
+    uint32_t magic = 0, version = 0, count = 0;
+    r.read(magic);
+    r.read(version);
+    if (!r.good() || magic != MAGIC || version != VERSION) {
+        std::cerr << "Not a compatible movie file: " << path << std::endl;
+        return false;
+    }
+    r.read(rom_hash);
+    r.read(seed);
+    r.read(count);
+    if (!r.good() || r.remaining() != (size_t)count * (sizeof(uint8_t) + sizeof(uint64_t))) {
+        std::cerr << "Truncated movie file: " << path << std::endl;
+        return false;
+    }
+    frames.resize(count);
+    for (Frame& f : frames) {
+        r.read(f.joy);
+        r.read(f.fb_hash);
+    }
+    return true;
+}
@@ -0,0 +1,212 @@
+#include "netplay.hpp"
+#include "machine.hpp"
+#include "rewind.hpp"
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Packet: magic, rom hash, ack, first input frame, input count, inputs,
+// newest final frame, its framebuffer hash
+static constexpr size_t HEADER_SIZE = 4 + 8 + 4 + 4 + 1;
+static constexpr size_t TRAILER_SIZE = 4 + 8;
+
+Netplay::Netplay() {}
+
+Netplay::~Netplay() {
+    close();
+}
+
+bool Netplay::open(uint16_t local_port, const std::string& peer, int p, int input_delay) {
+    size_t colon = peer.rfind(':');
+    if (colon == std::string::npos) {
+        std::cerr << "Netplay peer must be host:port, got " << peer << std::endl;
+        return false;
+    }
+    std::string host = peer.substr(0, colon);
+    std::string port = peer.substr(colon + 1);
+
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* res = nullptr;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0 || !res) {
+        std::cerr << "Could not resolve netplay peer " << peer << std::endl;
+        return false;
+    }
+    std::memcpy(peer_addr, res->ai_addr, std::min(sizeof(peer_addr), (size_t)res->ai_addrlen));
+    freeaddrinfo(res);
+
+    sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        std::cerr << "Could not create netplay socket" << std::endl;
+        return false;
+    }
+    sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(local_port);
+    if (bind(sock, (sockaddr*)&local, sizeof(local)) != 0) {
+        std::cerr << "Could not bind netplay port " << local_port << std::endl;
+        close();
+        return false;
+    }
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+
+    player = p == 2 ? 2 : 1;
+    // Frames before the input delay run with no local buttons held. They
+    // are sent like any other input, so the peer needn't use the same delay.
+    local_count = (uint32_t)std::max(0, std::min(input_delay, (int)MAX_PREDICTION));
+    std::memset(local_input, 0, sizeof(local_input));
+    remote_count = 0;
+    peer_ack = 0;
+    return true;
+}
+
+void Netplay::close() {
+    if (sock >= 0) {
+        ::close(sock);
+        sock = -1;
+    }
+}
+
+void Netplay::start(Machine& m, Rewinder& rw) {
+    base_frame = m.frame;
+    rw.clear();
+    rw.push(m); // Keyframe: lets a rollback reach all the way back to frame 0
+}
+
+void Netplay::poll(Machine& m) {
+    uint8_t buf[1024];
+    uint32_t simulated = m.frame - base_frame;
+    for (;;) {
+        ssize_t len = recv(sock, buf, sizeof(buf), 0);
+        if (len < 0) break; // EWOULDBLOCK: drained
+        if ((size_t)len < HEADER_SIZE + TRAILER_SIZE) continue;
+
+        uint32_t magic, ack, start, hash_frame;
+        uint64_t rom_hash, hash;
+        std::memcpy(&magic, buf, 4);
+        std::memcpy(&rom_hash, buf + 4, 8);
+        std::memcpy(&ack, buf + 12, 4);
+        std::memcpy(&start, buf + 16, 4);
+        uint8_t count = buf[20];
+        if (magic != MAGIC || (size_t)len != HEADER_SIZE + count + TRAILER_SIZE) continue;
+        if (rom_hash != m.rom_hash) {
+            if (!warned_rom) std::cerr << "Netplay peer is running a different ROM" << std::endl;
+            warned_rom = true;
+            continue;
+        }
+        std::memcpy(&hash_frame, buf + HEADER_SIZE + count, 4);
+        std::memcpy(&hash, buf + HEADER_SIZE + count + 4, 8);
+
+        peer_ack = std::max(peer_ack, ack);
+        const uint8_t* inputs = buf + HEADER_SIZE;
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t k = start + i;
+            if (k != remote_count) continue; // Duplicate, or a gap a later packet refills
+            remote_input[k % HISTORY] = inputs[i];
+            // A frame already simulated on a wrong guess has to be redone
+            if (k < simulated && predicted[k % HISTORY] != inputs[i]) rollback_to = std::min(rollback_to, k);
+            remote_count++;
+        }
+        if (hash_frame != UINT32_MAX) {
+            peer_hashes[hash_frame % HISTORY] = hash;
+            peer_hash_tags[hash_frame % HISTORY] = hash_frame + 1;
+            // Already final here: compare now, advance() has moved past it.
+            // Older than the ring means our own hash is gone.
+            if (hash_frame < checked_count && simulated - hash_frame <= HISTORY) check_hash(hash_frame);
+        }
+    }
+}
+
+void Netplay::send(Machine& m) {
+    uint8_t buf[HEADER_SIZE + 255 + TRAILER_SIZE];
+    uint32_t start = peer_ack;
+    uint8_t count = (uint8_t)std::min<uint32_t>(local_count - start, 255);
+    uint32_t simulated = m.frame - base_frame;
+    // Only frames simulated on confirmed input: a rollback poll() found but
+    // advance() hasn't applied yet leaves later hashes wrong
+    uint32_t final_count = std::min(std::min(remote_count, simulated), rollback_to);
+    uint32_t hash_frame = final_count ? final_count - 1 : UINT32_MAX;
+    uint64_t hash = final_count ? hashes[hash_frame % HISTORY] : 0;
+
+    std::memcpy(buf, &MAGIC, 4);
+    std::memcpy(buf + 4, &m.rom_hash, 8);
+    std::memcpy(buf + 12, &remote_count, 4);
+    std::memcpy(buf + 16, &start, 4);
+    buf[20] = count;
+    for (uint32_t i = 0; i < count; i++) buf[HEADER_SIZE + i] = local_input[(start + i) % HISTORY];
+    std::memcpy(buf + HEADER_SIZE + count, &hash_frame, 4);
+    std::memcpy(buf + HEADER_SIZE + count + 4, &hash, 8);
+    sendto(sock, buf, HEADER_SIZE + count + TRAILER_SIZE, 0, (sockaddr*)peer_addr, sizeof(sockaddr_in));
+}
+
+void Netplay::simulate(Machine& m, uint32_t frame) {
+    uint8_t local = local_input[frame % HISTORY];
+    uint8_t remote;
+    if (frame < remote_count) remote = remote_input[frame % HISTORY];
+    else remote = remote_count ? remote_input[(remote_count - 1) % HISTORY] : 0; // Buttons tend to stay held
+    predicted[frame % HISTORY] = remote;
+
+    if (player == 1) m.run_frame(local, remote);
+    else m.run_frame(remote, local);
+    hashes[frame % HISTORY] = m.frame_hash();
+}
+
+bool Netplay::advance(Machine& m, Rewinder& rw, uint8_t local_joy) {
+    if (sock < 0) return false;
+    poll(m);
+
+    uint32_t frame = m.frame - base_frame;
+    if (frame >= remote_count + MAX_PREDICTION) {
+        // Too far ahead of the peer: wait rather than risk a long rollback
+        stalls++;
+        send(m);
+        return false;
+    }
+
+    local_input[local_count % HISTORY] = local_joy;
+    local_count++;
+
+    if (rollback_to < frame) {
+        uint32_t steps = frame - rollback_to;
+        if (steps > rw.frames()) {
+            std::cerr << "Netplay rollback of " << steps << " frames exceeds the rewind history" << std::endl;
+            desynced = true;
+        } else {
+            for (uint32_t i = 0; i < steps; i++) rw.step_back(m);
+            m.apu.set_replaying(true);
+            for (uint32_t k = rollback_to; k < frame; k++) {
+                simulate(m, k);
+                rw.push(m);
+            }
+            m.apu.set_replaying(false);
+            rollback_frames += steps;
+        }
+    }
+    rollback_to = UINT32_MAX;
+
+    simulate(m, frame);
+    rw.push(m);
+    send(m);
+
+    // Compare every frame that is now final here whose peer hash is already
+    // in; the rest are compared by poll() when theirs arrives
+    uint32_t final_count = std::min(remote_count, frame + 1);
+    for (; checked_count < final_count; checked_count++) check_hash(checked_count);
+    return true;
+}
+
+void Netplay::check_hash(uint32_t k) {
+    if (peer_hash_tags[k % HISTORY] != k + 1) return;
+    if (peer_hashes[k % HISTORY] != hashes[k % HISTORY] && !desynced) {
+        std::cerr << "Netplay desync at frame " << k << std::endl;
+        desynced = true;
+    }
+}
@@ -0,0 +1,139 @@
+#include "preview.hpp"
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+
+static void put16(std::vector<uint8_t>& out, uint16_t v) {
+    out.push_back((uint8_t)v);
+    out.push_back((uint8_t)(v >> 8));
+}
+
+static void put32(std::vector<uint8_t>& out, uint32_t v) {
+    put16(out, (uint16_t)v);
+    put16(out, (uint16_t)(v >> 16));
+}
+
+PreviewStream::~PreviewStream() {
+    close();
+}
+
+bool PreviewStream::open(const std::string& target) {
+    size_t colon = target.rfind(':');
+    if (colon == std::string::npos) {
+        std::cerr << "Preview target must be host:port, got " << target << std::endl;
+        return false;
+    }
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* res = nullptr;
+    if (getaddrinfo(target.substr(0, colon).c_str(), target.substr(colon + 1).c_str(), &hints, &res) != 0 || !res) {
+        std::cerr << "Could not resolve preview target " << target << std::endl;
+        return false;
+    }
+    sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0 || connect(sock, res->ai_addr, res->ai_addrlen) != 0) {
+        std::cerr << "Live preview unavailable: nothing listening on " << target << std::endl;
+        freeaddrinfo(res);
+        close();
+        return false;
+    }
+    freeaddrinfo(res);
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+#ifdef SO_NOSIGPIPE
+    int one = 1;
+    setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+    sent.clear();
+    out.clear();
+    out_pos = 0;
+    return true;
+}
+
+void PreviewStream::close() {
+    if (sock >= 0) {
+        ::close(sock);
+        sock = -1;
+    }
+}
+
+bool PreviewStream::flush() {
+    while (out_pos < out.size()) {
+#ifdef MSG_NOSIGNAL
+        ssize_t n = send(sock, out.data() + out_pos, out.size() - out_pos, MSG_NOSIGNAL);
+#else
+        ssize_t n = send(sock, out.data() + out_pos, out.size() - out_pos, 0);
+#endif
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return false;
+            close(); // Studio went away
+            return false;
+        }
+        out_pos += n;
+    }
+    out.clear();
+    out_pos = 0;
+    return true;
+}
+
+bool PreviewStream::ready() {
+    return sock >= 0 && flush();
+}
+
+void PreviewStream::present(const uint32_t* pixels, int w, int h) {
+    if (!ready()) return; // Studio still busy: skip this frame
+
+    bool key = w != width || h != height || sent.empty();
+    if (key) {
+        width = w;
+        height = h;
+        sent.assign((size_t)w * h, 0);
+    }
+
+    std::vector<uint8_t> body;
+    put32(body, MAGIC);
+    put16(body, (uint16_t)w);
+    put16(body, (uint16_t)h);
+    put16(body, 0); // Rect count, patched below
+    uint16_t rects = 0;
+
+    for (int ty = 0; ty < h; ty += TILE) {
+        for (int tx = 0; tx < w; tx += TILE) {
+            int tw = std::min(TILE, w - tx), th = std::min(TILE, h - ty);
+            bool changed = key;
+            for (int y = ty; y < ty + th && !changed; y++) {
+                changed = std::memcmp(&pixels[(size_t)y * w + tx], &sent[(size_t)y * w + tx], tw * sizeof(uint32_t)) != 0;
+            }
+            if (!changed) continue;
+
+            put16(body, (uint16_t)tx);
+            put16(body, (uint16_t)ty);
+            put16(body, (uint16_t)tw);
+            put16(body, (uint16_t)th);
+            for (int y = ty; y < ty + th; y++) {
+                const uint32_t* src = &pixels[(size_t)y * w + tx];
+                std::memcpy(&sent[(size_t)y * w + tx], src, tw * sizeof(uint32_t));
+                for (int x = 0; x < tw; x++) { // ARGB -> RGBA bytes, as canvas ImageData wants
+                    body.push_back((uint8_t)(src[x] >> 16));
+                    body.push_back((uint8_t)(src[x] >> 8));
+                    body.push_back((uint8_t)src[x]);
+                    body.push_back(0xFF);
+                }
+            }
+            rects++;
+        }
+    }
+    if (rects == 0) return; // Nothing changed, nothing to send
+
+    body[8] = (uint8_t)rects;
+    body[9] = (uint8_t)(rects >> 8);
+    put32(out, (uint32_t)body.size());
+    out.insert(out.end(), body.begin(), body.end());
+    flush();
+}
@@ -0,0 +1,220 @@
+#include "recorder.hpp"
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// ARGB8888 -> planar YUV 4:4:4, BT.601 studio range. All intermediate
+// sums fit in 16 unsigned bits (U/V carry a +32768 bias), so the SIMD
+// path can work on eight pixels per step in plain 16-bit lanes.
+static void argb_to_yuv444(const uint32_t* src, uint8_t* y, uint8_t* u, uint8_t* v, size_t n) {
+    size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128i mask = _mm_set1_epi32(0xFF);
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= n; i += 8) {
+        __m128i p0 = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i p1 = _mm_loadu_si128((const __m128i*)(src + i + 4));
+        __m128i b = _mm_packs_epi32(_mm_and_si128(p0, mask), _mm_and_si128(p1, mask));
+        __m128i g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 8), mask), _mm_and_si128(_mm_srli_epi32(p1, 8), mask));
+        __m128i r = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 16), mask), _mm_and_si128(_mm_srli_epi32(p1, 16), mask));
+
+        __m128i yy = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(66)),
+                                                 _mm_mullo_epi16(g, _mm_set1_epi16(129))),
+                                   _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(25)), _mm_set1_epi16(16 * 256 + 128)));
+        __m128i uu = _mm_sub_epi16(_mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(112)), _mm_set1_epi16((short)(128 * 256 + 128))),
+                                   _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(38)), _mm_mullo_epi16(g, _mm_set1_epi16(74))));
+        __m128i vv = _mm_sub_epi16(_mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(112)), _mm_set1_epi16((short)(128 * 256 + 128))),
+                                   _mm_add_epi16(_mm_mullo_epi16(g, _mm_set1_epi16(94)), _mm_mullo_epi16(b, _mm_set1_epi16(18))));
+
+        _mm_storel_epi64((__m128i*)(y + i), _mm_packus_epi16(_mm_srli_epi16(yy, 8), zero));
+        _mm_storel_epi64((__m128i*)(u + i), _mm_packus_epi16(_mm_srli_epi16(uu, 8), zero));
+        _mm_storel_epi64((__m128i*)(v + i), _mm_packus_epi16(_mm_srli_epi16(vv, 8), zero));
+    }
+#endif
+    for (; i < n; i++) {
+        int r = (src[i] >> 16) & 0xFF, g = (src[i] >> 8) & 0xFF, b = src[i] & 0xFF;
+        y[i] = (uint8_t)((66 * r + 129 * g + 25 * b + 16 * 256 + 128) >> 8);
+        u[i] = (uint8_t)((112 * b - 38 * r - 74 * g + 128 * 256 + 128) >> 8);
+        v[i] = (uint8_t)((112 * r - 94 * g - 18 * b + 128 * 256 + 128) >> 8);
+    }
+}
+
+static void put16(uint8_t*& p, uint16_t v) { std::memcpy(p, &v, 2); p += 2; }
+static void put32(uint8_t*& p, uint32_t v) { std::memcpy(p, &v, 4); p += 4; }
+
+Recorder::~Recorder() {
+    close();
+}
+
+bool Recorder::open(const std::string& video_path, const std::string& wav_path, int w, int h,
+                    int rate, Policy p, size_t queue_frames) {
+    close();
+    width = w;
+    height = h;
+    sample_rate = rate;
+    policy = p;
+    capacity = std::max<size_t>(1, queue_frames);
+
+    if (!video_path.empty()) {
+        video_file.open(video_path, std::ios::binary);
+        if (!video_file) {
+            std::cerr << "Could not write capture: " << video_path << std::endl;
+            return false;
+        }
+        y4m = video_path.size() >= 4 && video_path.compare(video_path.size() - 4, 4, ".y4m") == 0;
+        if (y4m) {
+            video_file << "YUV4MPEG2 W" << width << " H" << height << " F60:1 Ip A1:1 C444\n";
+            yuv.resize((size_t)width * height * 3);
+        }
+    }
+    if (!wav_path.empty()) {
+        wav_file.open(wav_path, std::ios::binary);
+        if (!wav_file) {
+            std::cerr << "Could not write capture: " << wav_path << std::endl;
+            video_file.close();
+            return false;
+        }
+        audio_bytes = 0;
+        write_wav_header(); // Sizes are patched in close()
+    }
+
+    stopping = false;
+    running = true;
+    frames_captured = 0;
+    frames_dropped = 0;
+    pending_repeats = 0;
+    writer = std::thread(&Recorder::writer_loop, this);
+    return true;
+}
+
+void Recorder::close() {
+    if (!running) return;
+    {
+        std::lock_guard<std::mutex> lk(queue_lock);
+        if (pending_repeats || !pending_audio.empty()) {
+            // Frames dropped at the very end still need their slots and audio
+            Frame tail;
+            tail.repeats = pending_repeats;
+            tail.audio.swap(pending_audio);
+            queue.push_back(std::move(tail));
+            pending_repeats = 0;
+        }
+        stopping = true;
+    }
+    queue_cv.notify_all();
+    writer.join();
+    running = false;
+
+    if (wav_file.is_open()) {
+        wav_file.seekp(0);
+        write_wav_header();
+        wav_file.close();
+    }
+    video_file.close();
+    last_pixels.clear();
+}
+
+void Recorder::write(const float* stereo, int frames) {
+    if (running && wav_file.is_open()) {
+        pending_audio.insert(pending_audio.end(), stereo, stereo + frames * 2);
+        frame_has_audio = true;
+    }
+    if (forward) forward->write(stereo, frames);
+}
+
+void Recorder::present(const uint32_t* pixels, int w, int h) {
+    if (!running) return;
+    Frame f;
+    if (video_file.is_open() && w == width && h == height) f.pixels.assign(pixels, pixels + (size_t)w * h);
+    if (wav_file.is_open() && !frame_has_audio) {
+        // Muted frames (fast-forward, rewind) produce no samples; keep the
+        // WAV on the video timeline with silence
+        silence_accum += (double)sample_rate / 60.0;
+        int n = (int)silence_accum;
+        silence_accum -= n;
+        pending_audio.resize(pending_audio.size() + n * 2, 0.0f);
+    }
+    frame_has_audio = false;
+    f.audio.swap(pending_audio);
+    frames_captured++;
+
+    {
+        std::unique_lock<std::mutex> lk(queue_lock);
+        if (queue.size() >= capacity) {
+            if (policy == Policy::Drop) {
+                // The writer repeats the last picture; the audio rides along
+                // with the next frame that makes it into the queue
+                frames_dropped++;
+                pending_repeats++;
+                pending_audio.swap(f.audio);
+                return;
+            }
+            queue_cv.wait(lk, [&]() { return queue.size() < capacity; });
+        }
+        f.repeats = pending_repeats;
+        pending_repeats = 0;
+        queue.push_back(std::move(f));
+    }
+    queue_cv.notify_all();
+}
+
+void Recorder::writer_loop() {
+    for (;;) {
+        Frame f;
+        {
+            std::unique_lock<std::mutex> lk(queue_lock);
+            queue_cv.wait(lk, [&]() { return !queue.empty() || stopping; });
+            if (queue.empty()) break; // Stopping and fully drained
+            f = std::move(queue.front());
+            queue.pop_front();
+        }
+        queue_cv.notify_all();
+
+        if (video_file.is_open()) {
+            for (uint32_t i = 0; i < f.repeats && !last_pixels.empty(); i++) write_video(last_pixels);
+            if (!f.pixels.empty()) {
+                write_video(f.pixels);
+                last_pixels.swap(f.pixels);
+            }
+        }
+        if (wav_file.is_open() && !f.audio.empty()) {
+            wav_file.write((const char*)f.audio.data(), f.audio.size() * sizeof(float));
+            audio_bytes += f.audio.size() * sizeof(float);
+        }
+    }
+}
+
+void Recorder::write_video(const std::vector<uint32_t>& pixels) {
+    if (!y4m) {
+        video_file.write((const char*)pixels.data(), pixels.size() * sizeof(uint32_t));
+        return;
+    }
+    size_t n = pixels.size();
+    argb_to_yuv444(pixels.data(), &yuv[0], &yuv[n], &yuv[n * 2], n);
+    video_file << "FRAME\n";
+    video_file.write((const char*)yuv.data(), yuv.size());
+}
+
+void Recorder::write_wav_header() {
+    // RIFF/WAVE, IEEE float, interleaved stereo
+    uint8_t header[44];
+    uint8_t* p = header;
+    uint32_t data_bytes = (uint32_t)std::min<uint64_t>(audio_bytes, 0xFFFFFFFFu - 36);
+    std::memcpy(p, "RIFF", 4); p += 4;
+    put32(p, 36 + data_bytes);
+    std::memcpy(p, "WAVE", 4); p += 4;
+    std::memcpy(p, "fmt ", 4); p += 4;
+    put32(p, 16);
+    put16(p, 3); // WAVE_FORMAT_IEEE_FLOAT
+    put16(p, 2);
+    put32(p, (uint32_t)sample_rate);
+    put32(p, (uint32_t)sample_rate * 2 * sizeof(float));
+    put16(p, 2 * sizeof(float));
+    put16(p, 32);
+    std::memcpy(p, "data", 4); p += 4;
+    put32(p, data_bytes);
+    wav_file.write((const char*)header, sizeof(header));
+}
@@ -0,0 +1,148 @@
+#include "rewind.hpp"
+#include "machine.hpp"
+#include <algorithm>
+
+// Zero-run encoding of an XOR delta: repeated [varint zeros][varint n][n bytes]
+static void put_varint(std::vector<uint8_t>& out, uint32_t v) {
+    while (v >= 0x80) {
+        out.push_back((uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((uint8_t)v);
+}
+
+static uint32_t get_varint(const uint8_t*& p) {
+    uint32_t v = 0;
+    int shift = 0;
+    while (*p & 0x80) {
+        v |= (uint32_t)(*p++ & 0x7F) << shift;
+        shift += 7;
+    }
+    v |= (uint32_t)(*p++) << shift;
+    return v;
+}
+
+static void encode_xor(std::vector<uint8_t>& out, const uint8_t* a, const uint8_t* b, uint32_t size) {
+    uint32_t i = 0;
+    while (i < size) {
+        uint32_t zeros = 0;
+        while (i + zeros < size && a[i + zeros] == b[i + zeros]) zeros++;
+        i += zeros;
+        uint32_t lit = 0;
+        while (i + lit < size && a[i + lit] != b[i + lit]) lit++;
+        put_varint(out, zeros);
+        put_varint(out, lit);
+        for (uint32_t k = 0; k < lit; k++) out.push_back(a[i + k] ^ b[i + k]);
+        i += lit;
+    }
+}
+
+// Applies an encoded delta in place and returns the first byte after it
+static const uint8_t* apply_xor(const uint8_t* p, uint8_t* dst, uint32_t size) {
+    uint32_t i = 0;
+    while (i < size) {
+        i += get_varint(p);
+        uint32_t lit = get_varint(p);
+        for (uint32_t k = 0; k < lit; k++) dst[i + k] ^= *p++;
+        i += lit;
+    }
+    return p;
+}
+
+Rewinder::Rewinder(size_t capacity_bytes) : ring(capacity_bytes) {}
+
+void Rewinder::clear() {
+    entries.clear();
+    head = 0;
+    used = 0;
+}
+
+void Rewinder::push(Machine& m) {
+    Snapshot& snap = m.snapshot;
+    if (!snap.valid()) {
+        snap.capture(m); // First push only establishes the keyframe
+        return;
+    }
+
+    // Entry: [u32 page count][regs delta][pages: u32 index + page delta]
+    std::vector<uint8_t> entry;
+    const std::vector<uint32_t>& dirty = m.bus.dirty_pages();
+    uint32_t count = (uint32_t)dirty.size();
+    entry.insert(entry.end(), (uint8_t*)&count, (uint8_t*)&count + sizeof(count));
+
+    const std::vector<uint8_t>& old_regs = snap.get_regs();
+    std::vector<uint8_t> new_regs;
+    StateWriter w(new_regs);
+    m.save_state(w);
+    if (old_regs.size() != new_regs.size()) { // Layout changed: history is meaningless
+        clear();
+        snap.capture(m);
+        return;
+    }
+    encode_xor(entry, old_regs.data(), new_regs.data(), (uint32_t)new_regs.size());
+
+    for (uint32_t page : dirty) {
+        entry.insert(entry.end(), (uint8_t*)&page, (uint8_t*)&page + sizeof(page));
+        encode_xor(entry, snap.page_data(page), m.bus.page_data(page), Bus::PAGE_SIZE);
+    }
+
+    snap.capture(m);
+    append(entry);
+}
+
+bool Rewinder::step_back(Machine& m) {
+    if (entries.empty()) return false;
+    Span span = entries.back();
+    entries.pop_back();
+    used -= span.size;
+    head = span.offset;
+    read_back(span, scratch);
+
+    // Turn the mirror into the previous frame, then have restore() copy every
+    // page that differs: the ones in this delta plus any written since push.
+    Snapshot& snap = m.snapshot;
+    const uint8_t* p = scratch.data();
+    uint32_t count;
+    std::memcpy(&count, p, sizeof(count));
+    p += sizeof(count);
+
+    std::vector<uint8_t> regs = snap.get_regs();
+    p = apply_xor(p, regs.data(), (uint32_t)regs.size());
+    snap.set_regs(regs);
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t page;
+        std::memcpy(&page, p, sizeof(page));
+        p += sizeof(page);
+        p = apply_xor(p, snap.page_data(page), Bus::PAGE_SIZE);
+        m.bus.mark_page_dirty(page);
+    }
+
+    return snap.restore(m);
+}
+
+void Rewinder::append(const std::vector<uint8_t>& entry) {
+    if (entry.size() > ring.size() || ring.empty()) { // A single frame larger than the ring
+        clear();
+        return;
+    }
+    while (used + entry.size() > ring.size()) {
+        used -= entries.front().size;
+        entries.pop_front();
+    }
+
+    size_t first = std::min(entry.size(), ring.size() - head);
+    std::memcpy(&ring[head], entry.data(), first);
+    std::memcpy(&ring[0], entry.data() + first, entry.size() - first);
+
+    entries.push_back({head, entry.size()});
+    head = (head + entry.size()) % ring.size();
+    used += entry.size();
+}
+
+void Rewinder::read_back(const Span& span, std::vector<uint8_t>& out) const {
+    out.resize(span.size);
+    size_t first = std::min(span.size, ring.size() - span.offset);
+    std::memcpy(out.data(), &ring[span.offset], first);
+    std::memcpy(out.data() + first, &ring[0], span.size - first);
+}
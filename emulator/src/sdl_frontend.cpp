@@ -0,0 +1,209 @@
+#include "sdl_frontend.hpp"
+#include "apu.hpp"
+#include <iostream>
+#include <algorithm>
+
+SdlVideo::~SdlVideo() {
+    cleanup();
+}
+
+bool SdlVideo::init(int width, int height) {
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        std::cerr << "SDL could not initialize! SDL_Error: " << SDL_GetError() << std::endl;
+        return false;
+    }
+
+    window = SDL_CreateWindow("Zenu Emulator", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, width * 2, height * 2, SDL_WINDOW_SHOWN);
+    if (!window) {
+        std::cerr << "Window could not be created! SDL_Error: " << SDL_GetError() << std::endl;
+        return false;
+    }
+
+    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width, height);
+
+    return true;
+}
+
+void SdlVideo::present(const uint32_t* pixels, int width, int height) {
+    (void)height;
+    SDL_UpdateTexture(texture, NULL, pixels, width * sizeof(uint32_t));
+    SDL_RenderClear(renderer);
+    SDL_RenderCopy(renderer, texture, NULL, NULL);
+    SDL_RenderPresent(renderer);
+}
+
+void SdlVideo::cleanup() {
+    if (!window) return;
+    if (texture) SDL_DestroyTexture(texture);
+    if (renderer) SDL_DestroyRenderer(renderer);
+    SDL_DestroyWindow(window);
+    texture = nullptr;
+    renderer = nullptr;
+    window = nullptr;
+    SDL_Quit();
+}
+
+SdlAudio::~SdlAudio() {
+    cleanup();
+}
+
+bool SdlAudio::init(APU& a) {
+    apu = &a;
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0) {
+        std::cerr << "SDL Audio could not initialize! SDL_Error: " << SDL_GetError() << std::endl;
+        return false;
+    }
+
+    SDL_memset(&want, 0, sizeof(want));
+    want.freq = 48000; // Preferred rate, the device may pick its own
+    want.format = AUDIO_F32SYS; // 32-bit Floating Point Audio
+    want.channels = 2; // Stereo with per-channel panning
+    want.samples = 1024;
+    want.callback = audio_callback;
+    want.userdata = this;
+
+    // Take whatever rate/layout/format the device runs at natively so SDL
+    // doesn't insert its own conversion stage between us and the hardware.
+    deviceId = SDL_OpenAudioDevice(NULL, 0, &want, &have,
+        SDL_AUDIO_ALLOW_FREQUENCY_CHANGE | SDL_AUDIO_ALLOW_CHANNELS_CHANGE | SDL_AUDIO_ALLOW_FORMAT_CHANGE);
+    if (deviceId != 0 && have.format != AUDIO_F32SYS && have.format != AUDIO_S16SYS && have.format != AUDIO_S32SYS) {
+        // Exotic native format: let SDL convert from float instead
+        SDL_CloseAudioDevice(deviceId);
+        deviceId = SDL_OpenAudioDevice(NULL, 0, &want, &have,
+            SDL_AUDIO_ALLOW_FREQUENCY_CHANGE | SDL_AUDIO_ALLOW_CHANNELS_CHANGE);
+    }
+    if (deviceId == 0) {
+        std::cerr << "Failed to open audio: " << SDL_GetError() << std::endl;
+        return false;
+    }
+
+    out_channels = have.channels;
+    mix_buffer.resize(have.samples * 2);
+    apu->set_sample_rate(have.freq);
+
+    SDL_PauseAudioDevice(deviceId, 0);
+    return true;
+}
+
+void SdlAudio::cleanup() {
+    if (deviceId != 0) {
+        if (streaming) apu->set_sink(nullptr);
+        SDL_CloseAudioDevice(deviceId);
+        deviceId = 0;
+    }
+}
+
+void SdlAudio::set_streaming(bool enable, int latency_ms) {
+    SDL_LockAudioDevice(deviceId);
+    if (enable) {
+        target_fill = std::max(1, apu->get_sample_rate() * latency_ms / 1000);
+        uint32_t capacity = 1;
+        while (capacity < (uint32_t)target_fill * 4) capacity <<= 1;
+        ring.assign(capacity * 2, 0.0f);
+        ring_mask = capacity - 1;
+        ring_read = 0;
+        ring_write = 0;
+    }
+    streaming = enable;
+    apu->set_sink(enable ? this : nullptr);
+    SDL_UnlockAudioDevice(deviceId);
+}
+
+int SdlAudio::queued_frames() const {
+    return (int)(ring_write.load(std::memory_order_acquire) - ring_read.load(std::memory_order_acquire));
+}
+
+float SdlAudio::rate_ratio() {
+    // Dynamic rate control: nudge the number of samples produced per frame
+    // by at most MAX_RATE_SKEW so the queue converges on the target latency.
+    // The deviation is small enough that the pitch change is inaudible.
+    float deviation = (float)(queued_frames() - target_fill) / (float)target_fill;
+    deviation = std::max(-1.0f, std::min(1.0f, deviation));
+    return 1.0f - MAX_RATE_SKEW * deviation;
+}
+
+void SdlAudio::write(const float* stereo, int frames) {
+    uint32_t capacity = ring_mask + 1;
+    uint32_t write = ring_write.load(std::memory_order_relaxed);
+    frames = std::min(frames, (int)(capacity - (uint32_t)queued_frames())); // Never overrun the reader
+    for (int i = 0; i < frames; i++) {
+        uint32_t slot = (write & ring_mask) * 2;
+        ring[slot]     = stereo[i * 2];
+        ring[slot + 1] = stereo[i * 2 + 1];
+        write++;
+    }
+    ring_write.store(write, std::memory_order_release);
+}
+
+void SdlAudio::drain(float* out, int frames) {
+    uint32_t read = ring_read.load(std::memory_order_relaxed);
+    uint32_t avail = ring_write.load(std::memory_order_acquire) - read;
+
+    for (int i = 0; i < frames; i++) {
+        if ((uint32_t)i < avail) {
+            uint32_t slot = ((read + i) & ring_mask) * 2;
+            last_l = ring[slot];
+            last_r = ring[slot + 1];
+        } else {
+            // Underrun: decay the last sample to silence instead of clicking
+            last_l *= 0.995f;
+            last_r *= 0.995f;
+        }
+        out[i * 2]     = last_l;
+        out[i * 2 + 1] = last_r;
+    }
+    ring_read.store(read + std::min((uint32_t)frames, avail), std::memory_order_release);
+}
+
+void SdlAudio::audio_callback(void* userdata, uint8_t* stream, int len) {
+    SdlAudio* audio = (SdlAudio*)userdata;
+    int bytes_per_sample = SDL_AUDIO_BITSIZE(audio->have.format) / 8;
+    int frames = len / (bytes_per_sample * audio->out_channels);
+
+    int done = 0;
+    while (done < frames) {
+        int chunk = std::min(frames - done, (int)audio->mix_buffer.size() / 2);
+        float* mixed = audio->mix_buffer.data();
+        if (audio->streaming) audio->drain(mixed, chunk);
+        else audio->apu->render(mixed, chunk);
+
+        // Write the device's native layout: mono downmix, stereo, or stereo
+        // into the front pair with the remaining speakers left silent.
+        for (int i = 0; i < chunk; i++) {
+            float l = mixed[i * 2];
+            float r = mixed[i * 2 + 1];
+            for (int oc = 0; oc < audio->out_channels; oc++) {
+                float s = 0.0f;
+                if (audio->out_channels == 1) s = (l + r) * 0.5f;
+                else if (oc == 0) s = l;
+                else if (oc == 1) s = r;
+
+                int idx = (done + i) * audio->out_channels + oc;
+                if (audio->have.format == AUDIO_S16SYS) {
+                    ((int16_t*)stream)[idx] = (int16_t)(std::max(-1.0f, std::min(1.0f, s)) * 32767.0f);
+                } else if (audio->have.format == AUDIO_S32SYS) {
+                    ((int32_t*)stream)[idx] = (int32_t)(std::max(-1.0f, std::min(1.0f, s)) * 2147483520.0f);
+                } else {
+                    ((float*)stream)[idx] = s; // Direct 32-bit float output
+                }
+            }
+        }
+        done += chunk;
+    }
+}
+
+uint8_t SdlInput::poll_joy(int player) {
+    if (player != 0) return 0; // One keyboard, one player
+    const uint8_t* state = SDL_GetKeyboardState(NULL);
+    uint8_t joy = 0;
+    if (state[SDL_SCANCODE_UP])    joy |= (1 << 0);
+    if (state[SDL_SCANCODE_DOWN])  joy |= (1 << 1);
+    if (state[SDL_SCANCODE_LEFT])  joy |= (1 << 2);
+    if (state[SDL_SCANCODE_RIGHT]) joy |= (1 << 3);
+    if (state[SDL_SCANCODE_Z])     joy |= (1 << 4);
+    if (state[SDL_SCANCODE_X])     joy |= (1 << 5);
+    if (state[SDL_SCANCODE_RETURN]) joy |= (1 << 6);
+    if (state[SDL_SCANCODE_SPACE])  joy |= (1 << 7);
+    return joy;
+}
@@ -0,0 +1,136 @@
+#include "snapshot.hpp"
+#include "machine.hpp"
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+static bool page_is_zero(const uint8_t* page) {
+    const uint64_t* words = (const uint64_t*)page;
+    for (uint32_t i = 0; i < Bus::PAGE_SIZE / sizeof(uint64_t); i++) {
+        if (words[i]) return false;
+    }
+    return true;
+}
+
+void Snapshot::ensure_pages() {
+    // Bus memory starts zeroed and every later write is tracked, so a zeroed
+    // mirror is in sync with all pages that are not on the dirty list.
+    if (pages.empty()) pages.resize((size_t)Bus::STATE_PAGES * Bus::PAGE_SIZE, 0);
+}
+
+uint8_t* Snapshot::page_data(uint32_t page) {
+    ensure_pages();
+    return &pages[(size_t)page << Bus::PAGE_SHIFT];
+}
+
+void Snapshot::capture(Machine& m) {
+    ensure_pages();
+    for (uint32_t page : m.bus.dirty_pages()) {
+        std::memcpy(page_data(page), m.bus.page_data(page), Bus::PAGE_SIZE);
+    }
+    m.bus.clear_dirty();
+
+    regs.clear();
+    StateWriter w(regs);
+    m.save_state(w);
+}
+
+bool Snapshot::restore(Machine& m) {
+    if (!valid()) return false;
+    // Only pages written since the capture can differ from the mirror
+    for (uint32_t page : m.bus.dirty_pages()) {
+        std::memcpy(m.bus.page_data(page), page_data(page), Bus::PAGE_SIZE);
+    }
+    m.bus.clear_dirty();
+
+    StateReader r(regs.data(), regs.size());
+    return m.load_state(r);
+}
+
+bool Snapshot::write_file(const std::string& path, uint64_t rom_hash) const {
+    if (!valid()) return false;
+    std::vector<uint8_t> out;
+    StateWriter w(out);
+    w.write(MAGIC);
+    w.write(VERSION);
+    w.write(rom_hash);
+    w.write((uint32_t)regs.size());
+    w.write_bytes(regs.data(), regs.size());
+
+    // Most of the 32 MB is untouched; only non-zero pages go to disk
+    std::vector<uint32_t> used;
+    for (uint32_t p = 0; p < Bus::STATE_PAGES; p++) {
+        if (!page_is_zero(&pages[(size_t)p << Bus::PAGE_SHIFT])) used.push_back(p);
+    }
+    w.write((uint32_t)used.size());
+    for (uint32_t p : used) {
+        w.write(p);
+        w.write_bytes(&pages[(size_t)p << Bus::PAGE_SHIFT], Bus::PAGE_SIZE);
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Could not write state file: " << path << std::endl;
+        return false;
+    }
+    file.write((const char*)out.data(), out.size());
+    return (bool)file;
+}
+
+bool Snapshot::read_file(const std::string& path, uint64_t rom_hash) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Could not open state file: " << path << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    StateReader r(data.data(), data.size());
+
+    uint32_t magic = 0, version = 0, regs_size = 0, page_count = 0;
+    uint64_t hash = 0;
+    r.read(magic);
+    r.read(version);
+    r.read(hash);
+    if (!r.good() || magic != MAGIC || version != VERSION) {
+        std::cerr << "Not a compatible state file: " << path << std::endl;
+        return false;
+    }
+    if (hash != rom_hash) {
+        std::cerr << "State file belongs to a different ROM: " << path << std::endl;
+        return false;
+    }
+
+    // Validate everything before touching the mirror
+    r.read(regs_size);
+    if (!r.good() || regs_size > r.remaining()) {
+        std::cerr << "Truncated state file: " << path << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> new_regs(regs_size);
+    r.read_bytes(new_regs.data(), regs_size);
+    r.read(page_count);
+    if (!r.good() || r.remaining() != (size_t)page_count * (sizeof(uint32_t) + Bus::PAGE_SIZE)) {
+        std::cerr << "Truncated state file: " << path << std::endl;
+        return false;
+    }
+
+    const uint8_t* records = data.data() + (data.size() - r.remaining());
+    for (uint32_t i = 0; i < page_count; i++) {
+        uint32_t p;
+        std::memcpy(&p, records + (size_t)i * (sizeof(uint32_t) + Bus::PAGE_SIZE), sizeof(p));
+        if (p >= Bus::STATE_PAGES) {
+            std::cerr << "Corrupt state file: " << path << std::endl;
+            return false;
+        }
+    }
+
+    ensure_pages();
+    std::fill(pages.begin(), pages.end(), 0);
+    for (uint32_t i = 0; i < page_count; i++) {
+        uint32_t p = 0;
+        r.read(p);
+        r.read_bytes(page_data(p), Bus::PAGE_SIZE);
+    }
+    regs.swap(new_regs);
+    return true;
+}
@@ -12,6 +12,11 @@ namespace zenu {
 
     void audio_play_note(int channel, float frequency, float volume, WaveType type);
     void audio_stop(int channel);
+
+    // Envelope for notes on a channel: attack, decay and release in
+    // seconds, sustain as a fraction of the note's volume. The default
+    // (0, 0, 1, 0) switches notes hard on and off. PC only for now.
+    void audio_set_envelope(int channel, float attack, float decay, float sustain, float release);
 }
 
 #endif
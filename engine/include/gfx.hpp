@@ -4,16 +4,39 @@
 #include "types.hpp"
 
 namespace zenu {
+    struct Vertex {
+        i32 x, y;
+        Color color;
+    };
+
     void gfx_init();
     void gfx_begin_frame();
     void gfx_clear(Color color);
     void gfx_draw_rect(i32 x, i32 y, i32 w, i32 h, Color color);
     void gfx_draw_line(i32 x1, i32 y1, i32 x2, i32 y2, Color color);
     void gfx_draw_triangle(i32 x1, i32 y1, i32 x2, i32 y2, i32 x3, i32 y3, Color color);
-    void gfx_draw_char(i32 x, i32 y, char c, Color color);
-    void gfx_draw_text(i32 x, i32 y, const char* text, Color color);
+    // count / 3 filled triangles, each flat-shaded with its first vertex's color
+    void gfx_draw_triangles(const Vertex* vertices, i32 count);
+    // scale: integer magnification of the 8x8 font
+    void gfx_draw_char(i32 x, i32 y, char c, Color color, i32 scale = 1);
+    void gfx_draw_text(i32 x, i32 y, const char* text, Color color, i32 scale = 1);
     void gfx_draw_sprite(i32 x, i32 y, i32 w, i32 h, const u32* data);
+    // w * h palette indices drawn as one image. Indices at or past
+    // palette_size are transparent.
+    void gfx_draw_indexed_bitmap(i32 x, i32 y, i32 w, i32 h, const u8* pixels, const Color* palette, i32 palette_size = 256);
     void gfx_end_frame();
+
+    // Display lists: gfx_* calls made between gfx_list_begin() and
+    // gfx_list_end() are recorded instead of drawn, and gfx_list_draw()
+    // replays them in one call. Sprites and bitmaps are kept by pointer,
+    // so their pixels are read at replay. Lists don't nest while recording
+    // (begin returns 0), but a recorded list may draw another list: its
+    // commands are copied in at that point.
+    typedef u32 DisplayList; // 0 is never a valid list
+    DisplayList gfx_list_begin();
+    void gfx_list_end();
+    void gfx_list_draw(DisplayList list);
+    void gfx_list_free(DisplayList list);
 }
 
 #endif
@@ -22,9 +22,17 @@ namespace zenu {
         AXIS_RIGHT_Y
     };
 
-    bool input_is_down(Button btn);
-    bool input_just_pressed(Button btn);
-    float input_get_axis(AnalogAxis axis);
+    // Player 0 is the keyboard plus the first controller; further
+    // controllers take players 1, 2, ... in the order they are plugged in
+    // (PC). On Zenu players 0 and 1 are the two joypad ports.
+    const int INPUT_MAX_PLAYERS = 4;
+
+    // Queries read a snapshot taken once per update, so they are cheap
+    bool input_is_down(Button btn, int player = 0);
+    bool input_just_pressed(Button btn, int player = 0);
+    float input_get_axis(AnalogAxis axis, int player = 0);
+    // time_us() of the press behind a held button, for latency-aware games
+    u64 input_pressed_at(Button btn, int player = 0);
     
     // Internal use by backend
     void update_input_state();
@@ -0,0 +1,31 @@
+#ifndef ZENU_TIMER_HPP
+#define ZENU_TIMER_HPP
+
+#include "types.hpp"
+
+namespace zenu {
+    // Monotonic time in microseconds since boot
+    u64 time_us();
+    // CPU cycles (host performance counter ticks on PC)
+    u64 time_cycles();
+    // Retired instructions (not available on PC, returns 0)
+    u64 time_instret();
+
+    struct FrameStats {
+        float cpu_ms;     // Frame start to end of draw (updates, draw, submit)
+        float present_ms; // Upload and buffer swap
+        u32 updates;      // game_update() calls in the last frame
+        u32 dropped;      // Frames never shown because the game fell behind
+    };
+
+    // Target frame rate. game_update() stays locked to wall time at this
+    // rate, making up late frames with at most 4 extra catch-up updates per
+    // frame; time missed beyond that is dropped (and counted in
+    // FrameStats::dropped). PC only; Zenu follows the display's vblank.
+    void frame_set_rate(u32 hz);
+    // Fixed update timestep in seconds
+    float frame_dt();
+    FrameStats frame_stats();
+}
+
+#endif
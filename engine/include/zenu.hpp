@@ -6,11 +6,21 @@
 #include "gfx.hpp"
 #include "input.hpp"
 #include "audio.hpp"
+#include "timer.hpp"
 
-// User-implemented hooks
-extern void game_init();
-extern void game_update();
-extern void game_draw();
+// User-implemented hooks (C linkage so the PC hot-reload host can look
+// them up in a rebuilt game library)
+extern "C" void game_init();
+extern "C" void game_update();
+extern "C" void game_draw();
+
+// Optional, PC hot-reload only: a plain-data block carried over when the
+// game library is swapped. If its size still matches after a rebuild it is
+// copied into the new library and game_init() is skipped.
+extern "C" void* game_hot_state(zenu::u32* size);
+
+#define ZENU_HOT_STATE(obj) \
+    extern "C" void* game_hot_state(zenu::u32* size) { *size = sizeof(obj); return &(obj); }
 
 namespace zenu {
     // Engine internals
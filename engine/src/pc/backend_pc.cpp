@@ -1,53 +1,756 @@
 #ifdef PLATFORM_PC
 #include "zenu.hpp"
 #include "font.hpp"
+#include "preview.hpp"
 #include <SDL2/SDL.h>
 #include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <cmath>
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define ZENU_AVX2_DISPATCH 1 // AVX2 paths are compiled in and picked at runtime
+#endif
+
+static constexpr int SCREEN_W = 800;
+static constexpr int SCREEN_H = 600;
 
 // --- SDL2 State ---
 struct PCContext {
     SDL_Window* window;
     SDL_Renderer* renderer;
     SDL_AudioDeviceID audioDevice;
-    SDL_GameController* controller;
     bool running;
 };
 static PCContext pc;
 
+// --- Glyph Atlas ---
+// font_8x8 is baked at init into one texture: a 16x6 grid of glyph cells
+// plus a solid white cell. Untextured primitives sample the white cell, so
+// rects, lines and text all land in the same batch.
+static constexpr int ATLAS_W = 128;
+static constexpr int ATLAS_H = 64;
+static constexpr float WHITE_U = 4.0f / ATLAS_W;         // Centre of cell (0, 6)
+static constexpr float WHITE_V = (6 * 8 + 4.0f) / ATLAS_H;
+static SDL_Texture* atlas;
+
+static SDL_Texture* create_atlas(SDL_Renderer* renderer) {
+    std::vector<Uint32> pixels((size_t)ATLAS_W * ATLAS_H, 0x00FFFFFFu);
+    for (int g = 0; g < 96; g++) {
+        int gx = (g % 16) * 8, gy = (g / 16) * 8;
+        for (int row = 0; row < 8; row++) {
+            for (int col = 0; col < 8; col++) {
+                if (zenu::font_8x8[g][row] & (0x80 >> col)) pixels[(size_t)(gy + row) * ATLAS_W + gx + col] = 0xFFFFFFFFu;
+            }
+        }
+    }
+    for (int row = 0; row < 8; row++) {
+        for (int col = 0; col < 8; col++) pixels[(size_t)(6 * 8 + row) * ATLAS_W + col] = 0xFFFFFFFFu;
+    }
+
+    SDL_Texture* tex = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, ATLAS_W, ATLAS_H);
+    if (!tex) return nullptr;
+    SDL_UpdateTexture(tex, NULL, pixels.data(), ATLAS_W * sizeof(Uint32));
+    SDL_SetTextureBlendMode(tex, SDL_BLENDMODE_BLEND);
+    return tex;
+}
+
+// --- Draw Batch ---
+// Primitives are recorded as coloured, textured triangles and submitted
+// at the end of the frame with one SDL_RenderGeometry call per run of
+// consecutive primitives sharing a texture (the glyph atlas for
+// everything but sprites), instead of a SetRenderDrawColor + FillRect
+// round trip per primitive.
+struct DrawBatch {
+    struct Run {
+        SDL_Texture* texture;
+        int first; // Into indices
+    };
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+    std::vector<Run> runs;
+};
+static DrawBatch frame_batch;
+static DrawBatch* batch = &frame_batch; // Redirected while a display list is compiled
+
+static void batch_use(SDL_Texture* texture) {
+    if (batch->runs.empty() || batch->runs.back().texture != texture) {
+        batch->runs.push_back({texture, (int)batch->indices.size()});
+    }
+}
+
+static void batch_push_quad(SDL_Texture* texture, const SDL_Vertex (&v)[4]) {
+    batch_use(texture);
+    int base = (int)batch->vertices.size();
+    batch->vertices.insert(batch->vertices.end(), v, v + 4);
+    const int quad[6] = {0, 1, 2, 0, 2, 3};
+    for (int i : quad) batch->indices.push_back(base + i);
+}
+
+static void batch_quad(float x0, float y0, float x1, float y1, float x2, float y2, float x3, float y3, zenu::Color color) {
+    SDL_Color c = {color.r, color.g, color.b, color.a};
+    SDL_FPoint uv = {WHITE_U, WHITE_V};
+    const SDL_Vertex v[4] = {{{x0, y0}, c, uv}, {{x1, y1}, c, uv}, {{x2, y2}, c, uv}, {{x3, y3}, c, uv}};
+    batch_push_quad(atlas, v);
+}
+
+static void batch_triangle(float x1, float y1, float x2, float y2, float x3, float y3, zenu::Color color) {
+    batch_use(atlas);
+    int base = (int)batch->vertices.size();
+    SDL_Color c = {color.r, color.g, color.b, color.a};
+    SDL_FPoint uv = {WHITE_U, WHITE_V};
+    batch->vertices.push_back({{x1, y1}, c, uv});
+    batch->vertices.push_back({{x2, y2}, c, uv});
+    batch->vertices.push_back({{x3, y3}, c, uv});
+    for (int i = 0; i < 3; i++) batch->indices.push_back(base + i);
+}
+
+// Axis-aligned quad showing atlas texels [u0, u1) x [v0, v1)
+static void batch_glyph(float x0, float y0, float x1, float y1, int u0, int v0, int u1, int v1, zenu::Color color) {
+    SDL_Color c = {color.r, color.g, color.b, color.a};
+    float s0 = (float)u0 / ATLAS_W, t0 = (float)v0 / ATLAS_H, s1 = (float)u1 / ATLAS_W, t1 = (float)v1 / ATLAS_H;
+    const SDL_Vertex v[4] = {{{x0, y0}, c, {s0, t0}}, {{x1, y0}, c, {s1, t0}}, {{x1, y1}, c, {s1, t1}}, {{x0, y1}, c, {s0, t1}}};
+    batch_push_quad(atlas, v);
+}
+
+// Whole texture, unmodulated
+static void batch_image(SDL_Texture* texture, float x0, float y0, float x1, float y1) {
+    SDL_Color c = {255, 255, 255, 255};
+    const SDL_Vertex v[4] = {{{x0, y0}, c, {0, 0}}, {{x1, y0}, c, {1, 0}}, {{x1, y1}, c, {1, 1}}, {{x0, y1}, c, {0, 1}}};
+    batch_push_quad(texture, v);
+}
+
+static void batch_clear() {
+    batch->vertices.clear();
+    batch->indices.clear();
+    batch->runs.clear();
+}
+
+static void batch_flush() {
+    for (size_t i = 0; i < batch->runs.size(); i++) {
+        int first = batch->runs[i].first;
+        int end = i + 1 < batch->runs.size() ? batch->runs[i + 1].first : (int)batch->indices.size();
+        SDL_RenderGeometry(pc.renderer, batch->runs[i].texture, batch->vertices.data(), (int)batch->vertices.size(),
+                           batch->indices.data() + first, end - first);
+    }
+    batch_clear();
+}
+
+// --- Sprite Cache ---
+// One texture per sprite, keyed by the pixel pointer the game passes in.
+// The content is hashed on every draw, so the upload only happens when the
+// pixels (or the size) actually change. Entries not drawn for a while are
+// dropped, so sprites built in temporary buffers don't pile up. Indexed
+// bitmaps share the cache with streaming textures they convert into.
+struct CachedSprite {
+    SDL_Texture* texture = nullptr;
+    zenu::i32 w = 0, h = 0;
+    bool streaming = false;
+    zenu::u64 hash = 0;
+    zenu::u32 last_used = UINT32_MAX;
+};
+static std::unordered_map<const void*, CachedSprite> sprite_cache;
+static zenu::u32 sprite_frame = 0;
+static constexpr zenu::u32 SPRITE_IDLE_FRAMES = 300;
+
+static zenu::u64 hash_pixels(const zenu::u32* data, size_t n) {
+    zenu::u64 h = 1469598103934665603ull; // FNV-1a, a word at a time
+    for (size_t i = 0; i < n; i++) h = (h ^ data[i]) * 1099511628211ull;
+    return h;
+}
+
+// Returns the entry for key with a texture of the right size and kind, or
+// nullptr. The caller is about to change the texture's pixels.
+static CachedSprite* sprite_entry(const void* key, zenu::i32 w, zenu::i32 h, bool streaming) {
+    CachedSprite& s = sprite_cache[key];
+    if (s.texture && s.last_used == sprite_frame) {
+        batch_flush(); // Already drawn this frame with the old pixels
+    }
+    s.last_used = sprite_frame;
+    if (s.texture && s.w == w && s.h == h && s.streaming == streaming) return &s;
+
+    if (s.texture) SDL_DestroyTexture(s.texture);
+    s.texture = SDL_CreateTexture(pc.renderer, SDL_PIXELFORMAT_ARGB8888,
+                                  streaming ? SDL_TEXTUREACCESS_STREAMING : SDL_TEXTUREACCESS_STATIC, w, h);
+    if (!s.texture) {
+        sprite_cache.erase(key);
+        return nullptr;
+    }
+    SDL_SetTextureBlendMode(s.texture, SDL_BLENDMODE_BLEND);
+    s.w = w;
+    s.h = h;
+    s.streaming = streaming;
+    s.hash = 0;
+    return &s;
+}
+
+static SDL_Texture* cached_sprite(const zenu::u32* data, zenu::i32 w, zenu::i32 h) {
+    zenu::u64 hash = hash_pixels(data, (size_t)w * h);
+    auto it = sprite_cache.find(data);
+    if (it != sprite_cache.end() && it->second.texture && !it->second.streaming &&
+        it->second.w == w && it->second.h == h && it->second.hash == hash) {
+        it->second.last_used = sprite_frame;
+        return it->second.texture;
+    }
+
+    CachedSprite* s = sprite_entry(data, w, h, false);
+    if (!s) return nullptr;
+    SDL_UpdateTexture(s->texture, NULL, data, w * sizeof(zenu::u32));
+    s->hash = hash;
+    return s->texture;
+}
+
+// 8-bit indices through a 256-entry ARGB table. Without a gather
+// instruction there is nothing for SSE2 to speed up, so the vector path
+// is AVX2 only (8 lookups per step). The builds don't pass -mavx2, so it
+// is compiled for that target alone and chosen by a CPU check.
+#ifdef ZENU_AVX2_DISPATCH
+__attribute__((target("avx2")))
+static void indexed_to_argb_avx2(const zenu::u8* src, Uint32* dst, int n, const Uint32* table) {
+    for (int i = 0; i + 8 <= n; i += 8) {
+        __m256i idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src + i)));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_i32gather_epi32((const int*)table, idx, 4));
+    }
+}
+#endif
+
+static void indexed_to_argb(const zenu::u8* src, Uint32* dst, int n, const Uint32* table) {
+    int i = 0;
+#ifdef ZENU_AVX2_DISPATCH
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    if (avx2) {
+        i = n & ~7;
+        indexed_to_argb_avx2(src, dst, i, table);
+    }
+#endif
+    for (; i + 4 <= n; i += 4) {
+        dst[i] = table[src[i]];
+        dst[i + 1] = table[src[i + 1]];
+        dst[i + 2] = table[src[i + 2]];
+        dst[i + 3] = table[src[i + 3]];
+    }
+    for (; i < n; i++) dst[i] = table[src[i]];
+}
+
+#ifdef ZENU_HOT_RELOAD
+// Drops every cached texture (between frames). Needed whenever the
+// pointers may now name different data, e.g. after the game library has
+// been swapped out.
+static void sprite_cache_clear() {
+    for (auto& entry : sprite_cache) SDL_DestroyTexture(entry.second.texture);
+    sprite_cache.clear();
+}
+#endif
+
+static void sprite_cache_trim() {
+    sprite_frame++;
+    for (auto it = sprite_cache.begin(); it != sprite_cache.end();) {
+        if (sprite_frame - it->second.last_used > SPRITE_IDLE_FRAMES) {
+            SDL_DestroyTexture(it->second.texture);
+            it = sprite_cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+// --- Software Framebuffer ---
+// Chosen at init with ZENU_RENDERER=software: primitives are rasterized
+// straight into a CPU-side ARGB8888 buffer that is uploaded once per frame.
+// Integer math only, so the output is bit-identical on every host.
+struct SoftTarget {
+    bool enabled = false;
+    std::vector<Uint32> pixels; // SCREEN_W * SCREEN_H
+    SDL_Texture* texture = nullptr;
+};
+static SoftTarget soft;
+
+// Rounded (sa + d * ia) / 255 with sa = s * a pre-biased by 128. Exact for
+// all 8-bit inputs; the SIMD path below uses the same steps in 16-bit lanes.
+static inline Uint32 blend_channel(Uint32 sa, Uint32 d, Uint32 ia) {
+    Uint32 v = sa + d * ia;
+    return (v + (v >> 8)) >> 8;
+}
+
+static void soft_span(int y, int x0, int x1, zenu::Color c) {
+    if (y < 0 || y >= SCREEN_H || c.a == 0) return;
+    if (x0 < 0) x0 = 0;
+    if (x1 > SCREEN_W) x1 = SCREEN_W;
+    if (x0 >= x1) return;
+    Uint32* p = &soft.pixels[(size_t)y * SCREEN_W + x0];
+    int n = x1 - x0, i = 0;
+
+    if (c.a == 255) {
+        Uint32 v = 0xFF000000u | (c.r << 16) | (c.g << 8) | c.b;
+#if defined(__SSE2__) || defined(_M_X64)
+        __m128i vv = _mm_set1_epi32((int)v);
+        for (; i + 4 <= n; i += 4) _mm_storeu_si128((__m128i*)(p + i), vv);
+#endif
+        for (; i < n; i++) p[i] = v;
+        return;
+    }
+
+    Uint32 ia = 255 - c.a;
+    Uint32 sr = c.r * c.a + 128, sg = c.g * c.a + 128, sb = c.b * c.a + 128;
+#if defined(__SSE2__) || defined(_M_X64)
+    // Two pixels per register as b, g, r, a lanes; alpha is forced opaque
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i src = _mm_set_epi16(0, (short)sr, (short)sg, (short)sb, 0, (short)sr, (short)sg, (short)sb);
+    const __m128i inv = _mm_set1_epi16((short)ia);
+    const __m128i opaque = _mm_set1_epi32((int)0xFF000000u);
+    for (; i + 4 <= n; i += 4) {
+        __m128i d = _mm_loadu_si128((const __m128i*)(p + i));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), inv), src);
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), inv), src);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+        _mm_storeu_si128((__m128i*)(p + i), _mm_or_si128(_mm_packus_epi16(lo, hi), opaque));
+    }
+#endif
+    for (; i < n; i++) {
+        Uint32 d = p[i];
+        p[i] = 0xFF000000u | (blend_channel(sr, (d >> 16) & 0xFF, ia) << 16) |
+               (blend_channel(sg, (d >> 8) & 0xFF, ia) << 8) | blend_channel(sb, d & 0xFF, ia);
+    }
+}
+
+static void soft_line(int x1, int y1, int x2, int y2, zenu::Color c) {
+    if (y1 == y2) {
+        if (x1 > x2) std::swap(x1, x2);
+        soft_span(y1, x1, x2 + 1, c);
+        return;
+    }
+    // Bresenham; endpoints inclusive
+    int dx = abs(x2 - x1), dy = -abs(y2 - y1);
+    int sx = x1 < x2 ? 1 : -1, sy = y1 < y2 ? 1 : -1;
+    int err = dx + dy;
+    for (;;) {
+        soft_span(y1, x1, x1 + 1, c);
+        if (x1 == x2 && y1 == y2) break;
+        int e2 = 2 * err;
+        if (e2 >= dy) { err += dy; x1 += sx; }
+        if (e2 <= dx) { err += dx; y1 += sy; }
+    }
+}
+
+// ARGB pixels with per-pixel alpha: opaque runs are copied, transparent
+// ones skipped, the rest blended like soft_span
+static void soft_blit(int x, int y, int w, int h, const zenu::u32* data) {
+    int x0 = std::max(x, 0), x1 = std::min(x + w, SCREEN_W);
+    int y0 = std::max(y, 0), y1 = std::min(y + h, SCREEN_H);
+    for (int row = y0; row < y1; row++) {
+        const zenu::u32* src = data + (size_t)(row - y) * w + (x0 - x);
+        Uint32* dst = &soft.pixels[(size_t)row * SCREEN_W + x0];
+        for (int i = 0; i < x1 - x0; i++) {
+            Uint32 p = src[i], a = p >> 24;
+            if (a == 255) {
+                dst[i] = p;
+            } else if (a) {
+                Uint32 d = dst[i], ia = 255 - a;
+                dst[i] = 0xFF000000u | (blend_channel(((p >> 16) & 0xFF) * a + 128, (d >> 16) & 0xFF, ia) << 16) |
+                         (blend_channel(((p >> 8) & 0xFF) * a + 128, (d >> 8) & 0xFF, ia) << 8) |
+                         blend_channel((p & 0xFF) * a + 128, d & 0xFF, ia);
+            }
+        }
+    }
+}
+
+static inline int64_t floor_div(int64_t a, int64_t b) { // b > 0
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+// Fills the pixels whose centres lie inside the triangle, with a top-left
+// rule so triangles sharing an edge never overlap or leave gaps. Works in
+// doubled coordinates to keep pixel centres integral, and solves each edge
+// for its x bound per row instead of testing every pixel.
+static void soft_triangle(int x1, int y1, int x2, int y2, int x3, int y3, zenu::Color c) {
+    int64_t area = (int64_t)(x2 - x1) * (y3 - y1) - (int64_t)(y2 - y1) * (x3 - x1);
+    if (area == 0) return;
+    if (area < 0) { std::swap(x2, x3); std::swap(y2, y3); }
+
+    const int vx[3] = {x1, x2, x3}, vy[3] = {y1, y2, y3};
+    int64_t ex[3], ey[3], edx[3], edy[3], bias[3];
+    for (int i = 0; i < 3; i++) {
+        int j = (i + 1) % 3;
+        ex[i] = 2 * (int64_t)vx[i];
+        ey[i] = 2 * (int64_t)vy[i];
+        edx[i] = 2 * ((int64_t)vx[j] - vx[i]);
+        edy[i] = 2 * ((int64_t)vy[j] - vy[i]);
+        bool top_left = edy[i] < 0 || (edy[i] == 0 && edx[i] > 0);
+        bias[i] = top_left ? 0 : 1;
+    }
+
+    int min_x = std::min({x1, x2, x3}), max_x = std::max({x1, x2, x3});
+    int min_y = std::max(std::min({y1, y2, y3}), 0), max_y = std::min(std::max({y1, y2, y3}), SCREEN_H);
+    for (int y = min_y; y < max_y; y++) {
+        int64_t py = 2 * (int64_t)y + 1;
+        int64_t lo = min_x, hi = max_x - 1;
+        for (int i = 0; i < 3 && lo <= hi; i++) {
+            // Inside: edx * (py - ey) - edy * (px - ex) >= bias, px = 2x + 1
+            int64_t k = edx[i] * (py - ey[i]) + edy[i] * ex[i] - bias[i];
+            if (edy[i] == 0) {
+                if (k < 0) hi = lo - 1;
+            } else if (edy[i] < 0) {
+                int64_t px = -floor_div(k, -edy[i]); // ceil(-k / -edy)
+                lo = std::max(lo, -floor_div(-(px - 1), 2));
+            } else {
+                int64_t px = floor_div(k, edy[i]);
+                hi = std::min(hi, floor_div(px - 1, 2));
+            }
+        }
+        if (lo <= hi) soft_span(y, (int)std::max<int64_t>(lo, -1), (int)std::min<int64_t>(hi + 1, SCREEN_W), c);
+    }
+}
+
+// --- Frame Pacer ---
+// Presents on a fixed period measured with the performance counter: sleeps
+// for most of what is left of the frame and spins for the last stretch,
+// since SDL_Delay can overshoot by a millisecond or more. Simulation time
+// is locked to wall time; a frame that overruns by whole periods has them
+// made up with extra game_update() calls next frame (up to MAX_CATCH_UP).
+struct FramePacer {
+    Uint64 freq = 0;
+    Uint64 period = 0;      // Counter ticks per frame
+    Uint64 deadline = 0;    // When the current frame should be presented
+    Uint64 frame_start = 0;
+    zenu::u32 pending = 0;        // Updates owed from late frames
+    zenu::FrameStats stats = {};
+};
+static FramePacer pacer;
+static constexpr zenu::u32 DEFAULT_FRAME_RATE = 60;
+static constexpr zenu::u32 MAX_CATCH_UP = 4;
+
+static void pacer_wait(Uint64 until) {
+    // Bulk sleep up to 2 ms out, then 1 ms naps re-checked against the
+    // counter, so the spin only covers the last ~1 ms even when a nap runs long
+    Uint64 ms = pacer.freq / 1000;
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (until > now + 2 * ms) SDL_Delay((Uint32)((until - now - 2 * ms) / ms));
+    while (SDL_GetPerformanceCounter() + ms + ms / 4 < until) SDL_Delay(1);
+    while (SDL_GetPerformanceCounter() < until) {}
+}
+
+// --- Input ---
+// Built from SDL events in a single poll per frame (gfx_begin_frame), so
+// every input_* query is a plain memory read. Controllers are opened and
+// closed as SDL reports them plugged in and removed, including the ones
+// already present at startup.
+struct PlayerInput {
+    SDL_GameController* controller = nullptr;
+    SDL_JoystickID id = -1;
+    zenu::u8 pad = 0;             // Buttons held on the controller
+    float axes[4] = {};           // Controller sticks, dead zone applied
+    zenu::u8 prev = 0, curr = 0;  // Snapshots at the last two update_input_state() calls
+    zenu::u8 latched = 0;         // Pressed since the last snapshot, even if released again
+    zenu::u64 pressed_at[8] = {}; // Per button, time_us() of its last press event
+};
+struct InputState {
+    bool keys[SDL_NUM_SCANCODES] = {};
+    PlayerInput players[zenu::INPUT_MAX_PLAYERS];
+};
+static InputState input;
+
+// Indexed by button bit
+static const SDL_Scancode KEY_BUTTONS[8] = {
+    SDL_SCANCODE_UP, SDL_SCANCODE_DOWN, SDL_SCANCODE_LEFT, SDL_SCANCODE_RIGHT,
+    SDL_SCANCODE_Z, SDL_SCANCODE_X, SDL_SCANCODE_RETURN, SDL_SCANCODE_RSHIFT,
+};
+static const SDL_GameControllerButton PAD_BUTTONS[8] = {
+    SDL_CONTROLLER_BUTTON_DPAD_UP, SDL_CONTROLLER_BUTTON_DPAD_DOWN, SDL_CONTROLLER_BUTTON_DPAD_LEFT, SDL_CONTROLLER_BUTTON_DPAD_RIGHT,
+    SDL_CONTROLLER_BUTTON_A, SDL_CONTROLLER_BUTTON_B, SDL_CONTROLLER_BUTTON_START, SDL_CONTROLLER_BUTTON_BACK,
+};
+
+static PlayerInput* find_player(SDL_JoystickID id) {
+    for (PlayerInput& p : input.players) {
+        if (p.controller && p.id == id) return &p;
+    }
+    return nullptr;
+}
+
+static void open_controller(int device_index) {
+    SDL_GameController* gc = SDL_GameControllerOpen(device_index);
+    if (!gc) return;
+    SDL_JoystickID id = SDL_JoystickInstanceID(SDL_GameControllerGetJoystick(gc));
+    if (find_player(id)) {
+        SDL_GameControllerClose(gc); // Already have it; drop the extra reference
+        return;
+    }
+    for (PlayerInput& p : input.players) {
+        if (!p.controller) {
+            p.controller = gc;
+            p.id = id;
+            return;
+        }
+    }
+    SDL_GameControllerClose(gc); // More controllers than players
+}
+
+static void close_controller(SDL_JoystickID id) {
+    if (PlayerInput* p = find_player(id)) {
+        SDL_GameControllerClose(p->controller);
+        p->controller = nullptr;
+        p->id = -1;
+        p->pad = 0;
+        for (float& a : p->axes) a = 0.0f;
+    }
+}
+
+static void poll_input() {
+    // SDL stamps events with SDL_GetTicks() milliseconds; rebase to time_us()
+    zenu::u64 now_us = zenu::time_us();
+    Uint32 now_ms = SDL_GetTicks();
+    auto event_us = [&](Uint32 stamp) {
+        zenu::u64 age = (zenu::u64)(Uint32)(now_ms - stamp) * 1000;
+        return age < now_us ? now_us - age : 0;
+    };
+
+    SDL_Event e;
+    while (SDL_PollEvent(&e)) {
+        switch (e.type) {
+        case SDL_QUIT:
+            pc.running = false;
+            break;
+        case SDL_KEYDOWN:
+        case SDL_KEYUP: {
+            int code = e.key.keysym.scancode;
+            if (e.key.repeat || code < 0 || code >= SDL_NUM_SCANCODES) break;
+            bool down = e.type == SDL_KEYDOWN;
+            input.keys[code] = down;
+            for (int b = 0; b < 8; b++) {
+                if (down && KEY_BUTTONS[b] == code) {
+                    input.players[0].latched |= (zenu::u8)(1 << b);
+                    input.players[0].pressed_at[b] = event_us(e.key.timestamp);
+                }
+            }
+            break;
+        }
+        case SDL_CONTROLLERDEVICEADDED:
+            open_controller(e.cdevice.which);
+            break;
+        case SDL_CONTROLLERDEVICEREMOVED:
+            close_controller(e.cdevice.which);
+            break;
+        case SDL_CONTROLLERBUTTONDOWN:
+        case SDL_CONTROLLERBUTTONUP: {
+            PlayerInput* p = find_player(e.cbutton.which);
+            if (!p) break;
+            for (int b = 0; b < 8; b++) {
+                if (PAD_BUTTONS[b] != e.cbutton.button) continue;
+                if (e.type == SDL_CONTROLLERBUTTONDOWN) {
+                    p->pad |= (zenu::u8)(1 << b);
+                    p->latched |= (zenu::u8)(1 << b);
+                    p->pressed_at[b] = event_us(e.cbutton.timestamp);
+                } else {
+                    p->pad &= (zenu::u8)~(1 << b);
+                }
+            }
+            break;
+        }
+        case SDL_CONTROLLERAXISMOTION: {
+            PlayerInput* p = find_player(e.caxis.which);
+            if (!p || e.caxis.axis > SDL_CONTROLLER_AXIS_RIGHTY) break; // Same order as AnalogAxis
+            float v = e.caxis.value / 32767.0f;
+            if (v < -1.0f) v = -1.0f;
+            p->axes[e.caxis.axis] = (v > -0.1f && v < 0.1f) ? 0.0f : v;
+            break;
+        }
+        }
+    }
+}
+
+// --- Display Lists ---
+// gfx_* calls between gfx_list_begin() and gfx_list_end() are recorded as
+// commands. On the SDL path the primitives are then run once into the
+// list's own vertex/index arrays, so a replay is a copy into the frame
+// batch. Sprites, bitmaps and clears stay commands and are issued again
+// at replay (by pointer, so their pixels may change). Drawing a list while
+// recording copies its commands in, so lists never refer to each other.
+// The software renderer replays every command.
+struct ListCommand {
+    enum Kind : zenu::u8 { CLEAR, RECT, LINE, TRIANGLE, CHAR, TEXT, SPRITE, BITMAP } kind;
+    zenu::i32 v[6];
+    zenu::Color color;
+    const void* data;           // SPRITE/BITMAP pixels
+    const zenu::Color* palette; // BITMAP
+    size_t text;                // TEXT: offset into DisplayListData::text
+};
+
+struct DisplayListData {
+    std::vector<ListCommand> commands;
+    std::string text; // NUL-separated strings
+    DrawBatch geometry;
+    // Compiled replay order: a range of geometry, or one command
+    struct Step {
+        int command; // -1 for geometry
+        int first_vertex, vertex_count;
+        int first_index, index_count;
+    };
+    std::vector<Step> steps;
+    bool compiled = false;
+};
+static std::vector<std::unique_ptr<DisplayListData>> lists; // Handle = index + 1
+static DisplayListData* recording = nullptr;
+
+static void record(const ListCommand& c) {
+    recording->commands.push_back(c);
+}
+
+
+// Live preview for Zenu Studio, enabled by ZENU_PREVIEW=host:port
+static PreviewStream preview;
+static std::vector<Uint32> preview_pixels;
+
 // --- APU Emulator ---
-struct APUState {
-    float channels[4]; // Current sample value
-    float phase[4];    // Current phase
-    float freq[4];     // Frequency
-    float vol[4];      // Volume
-    zenu::u8 wave[4];        // Wave type
-    int duration[4];   // Duration in frames
+// The game thread only talks to the audio callback through a single-
+// producer/single-consumer command ring: it never takes the device lock or
+// waits on the audio thread. Note lengths and envelopes are counted in
+// samples on the audio thread, so they don't depend on the frame rate.
+static constexpr int AUDIO_RATE = 48000;
+static constexpr int NOTE_SAMPLES = AUDIO_RATE; // Default note length, one second
+
+enum AudioCommandType : zenu::u8 { AUDIO_NOTE_ON, AUDIO_NOTE_OFF, AUDIO_ENVELOPE };
+
+struct AudioCommand {
+    AudioCommandType type;
+    zenu::u8 channel;
+    zenu::u8 wave;
+    float args[4]; // NOTE_ON: freq, volume; ENVELOPE: attack, decay, sustain, release
 };
-static APUState apu;
+
+struct AudioQueue {
+    static constexpr zenu::u32 SIZE = 256; // Power of two
+    AudioCommand slots[SIZE];
+    std::atomic<zenu::u32> head{0}; // Advanced by the game thread
+    std::atomic<zenu::u32> tail{0}; // Advanced by the audio thread
+    zenu::u32 dropped = 0;          // Commands lost to a full ring (game thread)
+
+    void push(const AudioCommand& cmd) {
+        zenu::u32 h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == SIZE) {
+            if (dropped++ == 0) std::cerr << "Audio command ring full (device stalled?); dropping commands" << std::endl;
+            return;
+        }
+        slots[h % SIZE] = cmd;
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    bool pop(AudioCommand& cmd) {
+        zenu::u32 t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) return false;
+        cmd = slots[t % SIZE];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+};
+static AudioQueue audio_queue;
+
+// Everything below is touched by the audio thread only
+enum EnvelopeStage : zenu::u8 { ENV_OFF, ENV_ATTACK, ENV_DECAY, ENV_SUSTAIN, ENV_RELEASE };
+
+struct Voice {
+    float phase = 0.0f;
+    float freq = 0.0f;
+    float vol = 0.0f;
+    zenu::u8 wave = 0;
+    zenu::u32 noise = 0;     // xorshift32 state, never 0
+    // Envelope settings: per-sample steps, sustain level
+    float attack_step = 1.0f, decay_step = 1.0f, sustain = 1.0f, release_step = 1.0f;
+    EnvelopeStage stage = ENV_OFF;
+    float level = 0.0f;
+    int hold = 0;            // Samples until the note releases by itself
+};
+static Voice voices[4];
+
+// Seconds to a per-sample step over the full 0..1 range (0 = instant)
+static float envelope_step(float seconds) {
+    return seconds > 0.0f ? 1.0f / (seconds * AUDIO_RATE) : 1.0f;
+}
+
+static void apply_audio_command(const AudioCommand& cmd) {
+    Voice& v = voices[cmd.channel];
+    switch (cmd.type) {
+    case AUDIO_NOTE_ON:
+        v.freq = cmd.args[0];
+        v.vol = cmd.args[1];
+        v.wave = cmd.wave;
+        v.phase = 0.0f;
+        v.hold = NOTE_SAMPLES;
+        v.stage = ENV_ATTACK;
+        v.level = 0.0f;
+        break;
+    case AUDIO_NOTE_OFF:
+        if (v.stage != ENV_OFF) v.stage = ENV_RELEASE;
+        break;
+    case AUDIO_ENVELOPE:
+        v.attack_step = envelope_step(cmd.args[0]);
+        v.decay_step = envelope_step(cmd.args[1]);
+        v.sustain = cmd.args[2] < 0.0f ? 0.0f : (cmd.args[2] > 1.0f ? 1.0f : cmd.args[2]);
+        v.release_step = envelope_step(cmd.args[3]);
+        break;
+    }
+}
+
+static float envelope_tick(Voice& v) {
+    if (v.hold > 0 && --v.hold == 0 && v.stage != ENV_OFF) v.stage = ENV_RELEASE;
+    switch (v.stage) {
+    case ENV_ATTACK:
+        v.level += v.attack_step;
+        if (v.level >= 1.0f) { v.level = 1.0f; v.stage = ENV_DECAY; }
+        break;
+    case ENV_DECAY:
+        v.level -= v.decay_step;
+        if (v.level <= v.sustain) { v.level = v.sustain; v.stage = ENV_SUSTAIN; }
+        break;
+    case ENV_RELEASE:
+        v.level -= v.release_step;
+        if (v.level <= 0.0f) { v.level = 0.0f; v.stage = ENV_OFF; }
+        break;
+    default:
+        break;
+    }
+    return v.level;
+}
 
 void audio_callback(void* userdata, Uint8* stream, int len) {
+    AudioCommand cmd;
+    while (audio_queue.pop(cmd)) apply_audio_command(cmd);
+
     float* buffer = (float*)stream;
     int samples = len / sizeof(float);
     
     for (int i = 0; i < samples; i++) {
         float sample = 0.0f;
         for (int ch = 0; ch < 4; ch++) {
-            if (apu.duration[ch] > 0 && apu.vol[ch] > 0) {
-                float t = apu.phase[ch];
-                float s = 0.0f;
-                // Wave generation
-                switch (apu.wave[ch]) {
-                    case 0: s = (t < 0.5f) ? 1.0f : -1.0f; break; // Square
-                    case 1: s = sinf(t * 6.28318f); break;        // Sine
-                    case 2: s = (t < 0.5f) ? (4.0f * t - 1.0f) : (3.0f - 4.0f * t); break; // Triangle
-                    case 3: s = ((float)rand() / RAND_MAX) * 2.0f - 1.0f; break; // Noise
-                }
-                sample += s * apu.vol[ch];
-                
-                // Phase increment
-                apu.phase[ch] += apu.freq[ch] / 48000.0f;
-                if (apu.phase[ch] >= 1.0f) apu.phase[ch] -= 1.0f;
+            Voice& v = voices[ch];
+            if (v.stage == ENV_OFF) continue;
+            float level = envelope_tick(v) * v.vol;
+            float t = v.phase;
+            float s = 0.0f;
+            // Wave generation
+            switch (v.wave) {
+                case 0: s = (t < 0.5f) ? 1.0f : -1.0f; break; // Square
+                case 1: s = sinf(t * 6.28318f); break;        // Sine
+                case 2: s = (t < 0.5f) ? (4.0f * t - 1.0f) : (3.0f - 4.0f * t); break; // Triangle
+                case 3:                                       // Noise
+                    v.noise ^= v.noise << 13;
+                    v.noise ^= v.noise >> 17;
+                    v.noise ^= v.noise << 5;
+                    s = (float)(Sint32)v.noise * (1.0f / 2147483648.0f);
+                    break;
             }
+            sample += s * level;
+            
+            // Phase increment
+            v.phase += v.freq / AUDIO_RATE;
+            if (v.phase >= 1.0f) v.phase -= 1.0f;
         }
         buffer[i] = sample * 0.25f; // Mix
     }
@@ -56,31 +759,71 @@ void audio_callback(void* userdata, Uint8* stream, int len) {
 namespace zenu {
     void audio_play_note(int channel, float freq, float volume, WaveType wave_type) {
         if (channel < 0 || channel >= 4) return;
-        SDL_LockAudioDevice(pc.audioDevice);
-        apu.freq[channel] = freq;
-        apu.vol[channel] = volume;
-        apu.wave[channel] = (u8)wave_type;
-        apu.duration[channel] = 60; // Default duration
-        apu.phase[channel] = 0.0f;
-        SDL_UnlockAudioDevice(pc.audioDevice);
+        audio_queue.push({AUDIO_NOTE_ON, (u8)channel, (u8)wave_type, {freq, volume, 0, 0}});
     }
     
     void audio_stop(int channel) {
         if (channel < 0 || channel >= 4) return;
-        SDL_LockAudioDevice(pc.audioDevice);
-        apu.vol[channel] = 0;
-        apu.duration[channel] = 0;
-        SDL_UnlockAudioDevice(pc.audioDevice);
+        audio_queue.push({AUDIO_NOTE_OFF, (u8)channel, 0, {0, 0, 0, 0}});
+    }
+
+    void audio_set_envelope(int channel, float attack, float decay, float sustain, float release) {
+        if (channel < 0 || channel >= 4) return;
+        audio_queue.push({AUDIO_ENVELOPE, (u8)channel, 0, {attack, decay, sustain, release}});
+    }
+
+    u64 time_us() {
+        // Split so counter * 1000000 can't overflow (ns counters wrap it after ~5 h)
+        u64 c = SDL_GetPerformanceCounter();
+        u64 f = SDL_GetPerformanceFrequency();
+        return (c / f) * 1000000 + (c % f) * 1000000 / f;
+    }
+
+    u64 time_cycles() {
+        return SDL_GetPerformanceCounter();
+    }
+
+    u64 time_instret() {
+        return 0;
+    }
+
+    void frame_set_rate(u32 hz) {
+        if (hz == 0) return;
+        pacer.freq = SDL_GetPerformanceFrequency();
+        pacer.period = pacer.freq / hz;
+    }
+
+    float frame_dt() {
+        return (float)pacer.period / (float)pacer.freq;
+    }
+
+    FrameStats frame_stats() {
+        return pacer.stats;
     }
 
     void gfx_init() {
         if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_GAMECONTROLLER) < 0) exit(1);
-        pc.window = SDL_CreateWindow("Zenu Engine (PC)", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, 800, 600, SDL_WINDOW_SHOWN);
+        pc.window = SDL_CreateWindow("Zenu Engine (PC)", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, SCREEN_W, SCREEN_H, SDL_WINDOW_SHOWN);
         pc.renderer = SDL_CreateRenderer(pc.window, -1, SDL_RENDERER_ACCELERATED);
-        SDL_RenderSetLogicalSize(pc.renderer, 800, 600);
+        SDL_RenderSetLogicalSize(pc.renderer, SCREEN_W, SCREEN_H);
         pc.running = true;
+        if (!pacer.period) frame_set_rate(DEFAULT_FRAME_RATE);
+        atlas = create_atlas(pc.renderer);
+        if (!atlas) std::cerr << "Glyph atlas unavailable: " << SDL_GetError() << std::endl;
+
+        const char* renderer = getenv("ZENU_RENDERER");
+        if (renderer && strcmp(renderer, "software") == 0) {
+            soft.texture = SDL_CreateTexture(pc.renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, SCREEN_W, SCREEN_H);
+            if (soft.texture) {
+                soft.pixels.assign((size_t)SCREEN_W * SCREEN_H, 0xFF000000u);
+                soft.enabled = true;
+            } else {
+                std::cerr << "Software renderer unavailable, using SDL: " << SDL_GetError() << std::endl;
+            }
+        }
 
         // Audio Init
+        for (int i = 0; i < 4; i++) voices[i].noise = 0x9E3779B9u * (i + 1); // Nonzero, distinct
         SDL_AudioSpec want, have;
         SDL_zero(want);
         want.freq = 48000;
@@ -91,172 +834,497 @@ namespace zenu {
         pc.audioDevice = SDL_OpenAudioDevice(NULL, 0, &want, &have, 0);
         SDL_PauseAudioDevice(pc.audioDevice, 0);
 
-        // Controller Init
-        for (int i = 0; i < SDL_NumJoysticks(); ++i) {
-            if (SDL_IsGameController(i)) {
-                pc.controller = SDL_GameControllerOpen(i);
-                if (pc.controller) break;
-            }
-        }
+        if (const char* target = getenv("ZENU_PREVIEW")) preview.open(target);
     }
 
     void gfx_begin_frame() {
-        SDL_Event e;
-        while (SDL_PollEvent(&e)) {
-            if (e.type == SDL_QUIT) pc.running = false;
-        }
-        // Decrement audio timers
-        SDL_LockAudioDevice(pc.audioDevice);
-        for(int i=0; i<4; i++) if(apu.duration[i] > 0) apu.duration[i]--;
-        SDL_UnlockAudioDevice(pc.audioDevice);
+        Uint64 now = SDL_GetPerformanceCounter();
+        if (!pacer.deadline) pacer.deadline = now + pacer.period;
+        pacer.frame_start = now;
+        pacer.stats.updates = 1 + (pacer.pending < MAX_CATCH_UP ? pacer.pending : MAX_CATCH_UP);
+        pacer.pending = 0;
+
+        poll_input();
     }
 
     void gfx_clear(Color color) {
+        if (recording) { record({ListCommand::CLEAR, {}, color, nullptr, nullptr, 0}); return; }
+        if (soft.enabled) {
+            for (int y = 0; y < SCREEN_H; y++) soft_span(y, 0, SCREEN_W, {255, color.r, color.g, color.b});
+            return;
+        }
+        // Everything recorded so far would be wiped anyway
+        batch_clear();
         SDL_SetRenderDrawColor(pc.renderer, color.r, color.g, color.b, color.a);
         SDL_RenderClear(pc.renderer);
     }
 
     void gfx_draw_rect(i32 x, i32 y, i32 w, i32 h, Color color) {
-        SDL_SetRenderDrawColor(pc.renderer, color.r, color.g, color.b, color.a);
-        SDL_Rect rect = {x, y, w, h};
-        SDL_RenderFillRect(pc.renderer, &rect);
+        if (recording) { record({ListCommand::RECT, {x, y, w, h}, color, nullptr, nullptr, 0}); return; }
+        if (w <= 0 || h <= 0) return;
+        if (soft.enabled) {
+            int y0 = y < 0 ? 0 : y, y1 = y + h > SCREEN_H ? SCREEN_H : y + h;
+            for (int row = y0; row < y1; row++) soft_span(row, x, x + w, color);
+            return;
+        }
+        float x0 = (float)x, y0 = (float)y, x1 = (float)(x + w), y1 = (float)(y + h);
+        batch_quad(x0, y0, x1, y0, x1, y1, x0, y1, color);
     }
     
     void gfx_draw_line(i32 x1, i32 y1, i32 x2, i32 y2, Color color) {
-        SDL_SetRenderDrawColor(pc.renderer, color.r, color.g, color.b, color.a);
-        SDL_RenderDrawLine(pc.renderer, x1, y1, x2, y2);
+        if (recording) { record({ListCommand::LINE, {x1, y1, x2, y2}, color, nullptr, nullptr, 0}); return; }
+        if (soft.enabled) {
+            soft_line(x1, y1, x2, y2, color);
+            return;
+        }
+        // A one pixel wide quad through the pixel centres, extended half a
+        // pixel past both ends so both endpoints are covered like DrawLine
+        float dx = (float)(x2 - x1), dy = (float)(y2 - y1);
+        float len = sqrtf(dx * dx + dy * dy);
+        if (len == 0.0f) {
+            gfx_draw_rect(x1, y1, 1, 1, color);
+            return;
+        }
+        float ux = dx / len * 0.5f, uy = dy / len * 0.5f; // Half-pixel along the line
+        float ax = x1 + 0.5f - ux, ay = y1 + 0.5f - uy;
+        float bx = x2 + 0.5f + ux, by = y2 + 0.5f + uy;
+        batch_quad(ax - uy, ay + ux, bx - uy, by + ux, bx + uy, by - ux, ax + uy, ay - ux, color);
     }
 
     void gfx_draw_triangle(i32 x1, i32 y1, i32 x2, i32 y2, i32 x3, i32 y3, Color color) {
-        // Approximate triangle for PC (just draw edges for now to be simple, or lines)
-        gfx_draw_line(x1, y1, x2, y2, color);
-        gfx_draw_line(x2, y2, x3, y3, color);
-        gfx_draw_line(x3, y3, x1, y1, color);
+        if (recording) { record({ListCommand::TRIANGLE, {x1, y1, x2, y2, x3, y3}, color, nullptr, nullptr, 0}); return; }
+        if (soft.enabled) soft_triangle(x1, y1, x2, y2, x3, y3, color);
+        else batch_triangle((float)x1, (float)y1, (float)x2, (float)y2, (float)x3, (float)y3, color);
     }
-    
-    void gfx_draw_char(i32 x, i32 y, char c, Color color) {
-        if (c < 32 || c > 127) return;
-        const u8* glyph = font_8x8[c - 32];
+
+    void gfx_draw_triangles(const Vertex* v, i32 count) {
+        if (!soft.enabled) {
+            batch->vertices.reserve(batch->vertices.size() + count);
+            batch->indices.reserve(batch->indices.size() + count);
+        }
+        for (i32 i = 0; i + 2 < count; i += 3) {
+            gfx_draw_triangle(v[i].x, v[i].y, v[i + 1].x, v[i + 1].y, v[i + 2].x, v[i + 2].y, v[i].color);
+        }
+    }
+
+    void gfx_draw_char(i32 x, i32 y, char c, Color color, i32 scale) {
+        if (recording) { record({ListCommand::CHAR, {x, y, c, scale}, color, nullptr, nullptr, 0}); return; }
+        if (c < 32 || c > 127 || scale <= 0) return;
+        int g = c - 32;
+        if (atlas && !soft.enabled) {
+            int u = (g % 16) * 8, v = (g / 16) * 8;
+            batch_glyph((float)x, (float)y, (float)(x + 8 * scale), (float)(y + 8 * scale), u, v, u + 8, v + 8, color);
+            return;
+        }
+        const u8* glyph = font_8x8[g];
         for (int row = 0; row < 8; row++) {
-            for (int col = 0; col < 8; col++) {
-                if (glyph[row] & (0x80 >> col)) {
-                    gfx_draw_rect(x + col, y + row, 1, 1, color);
-                }
+            // One rect per horizontal run of set pixels
+            int col = 0;
+            while (col < 8) {
+                if (!(glyph[row] & (0x80 >> col))) { col++; continue; }
+                int start = col;
+                while (col < 8 && (glyph[row] & (0x80 >> col))) col++;
+                gfx_draw_rect(x + start * scale, y + row * scale, (col - start) * scale, scale, color);
             }
         }
     }
 
-    void gfx_draw_text(i32 x, i32 y, const char* text, Color color) {
+    void gfx_draw_text(i32 x, i32 y, const char* text, Color color, i32 scale) {
+        if (recording) {
+            record({ListCommand::TEXT, {x, y, scale}, color, nullptr, nullptr, recording->text.size()});
+            recording->text.append(text).push_back('\0');
+            return;
+        }
          int cx = x;
          while (*text) {
-             if (*text == '\n') { y += 9; cx = x; }
-             else { gfx_draw_char(cx, y, *text, color); cx += 8; }
+             if (*text == '\n') { y += 9 * scale; cx = x; }
+             else { gfx_draw_char(cx, y, *text, color, scale); cx += 8 * scale; }
              text++;
          }
     }
 
-    void gfx_end_frame() {
-        SDL_RenderPresent(pc.renderer);
-        SDL_Delay(16); // ~60 FPS cap
+    void gfx_draw_sprite(i32 x, i32 y, i32 w, i32 h, const u32* data) {
+        if (recording) { record({ListCommand::SPRITE, {x, y, w, h}, {}, data, nullptr, 0}); return; }
+        if (w <= 0 || h <= 0 || !data) return;
+        if (soft.enabled) {
+            soft_blit(x, y, w, h, data);
+            return;
+        }
+        if (SDL_Texture* tex = cached_sprite(data, w, h)) {
+            batch_image(tex, (float)x, (float)y, (float)(x + w), (float)(y + h));
+        }
     }
 
-    bool input_is_down(Button btn) {
-        const Uint8* k = SDL_GetKeyboardState(NULL);
-        bool pressed = false;
-        
-        switch (btn) {
-            case BUTTON_UP:    pressed = k[SDL_SCANCODE_UP]    || (pc.controller && SDL_GameControllerGetButton(pc.controller, SDL_CONTROLLER_BUTTON_DPAD_UP)); break;
-            case BUTTON_DOWN:  pressed = k[SDL_SCANCODE_DOWN]  || (pc.controller && SDL_GameControllerGetButton(pc.controller, SDL_CONTROLLER_BUTTON_DPAD_DOWN)); break;
-            case BUTTON_LEFT:  pressed = k[SDL_SCANCODE_LEFT]  || (pc.controller && SDL_GameControllerGetButton(pc.controller, SDL_CONTROLLER_BUTTON_DPAD_LEFT)); break;
-            case BUTTON_RIGHT: pressed = k[SDL_SCANCODE_RIGHT] || (pc.controller && SDL_GameControllerGetButton(pc.controller, SDL_CONTROLLER_BUTTON_DPAD_RIGHT)); break;
-            case BUTTON_A:     pressed = k[SDL_SCANCODE_Z]     || (pc.controller && SDL_GameControllerGetButton(pc.controller, SDL_CONTROLLER_BUTTON_A)); break;
-            case BUTTON_B:     pressed = k[SDL_SCANCODE_X]     || (pc.controller && SDL_GameControllerGetButton(pc.controller, SDL_CONTROLLER_BUTTON_B)); break;
-            case BUTTON_START: pressed = k[SDL_SCANCODE_RETURN]|| (pc.controller && SDL_GameControllerGetButton(pc.controller, SDL_CONTROLLER_BUTTON_START)); break;
-            case BUTTON_SELECT:pressed = k[SDL_SCANCODE_RSHIFT]|| (pc.controller && SDL_GameControllerGetButton(pc.controller, SDL_CONTROLLER_BUTTON_BACK)); break;
+    void gfx_draw_indexed_bitmap(i32 x, i32 y, i32 w, i32 h, const u8* pixels, const Color* palette, i32 palette_size) {
+        if (recording) { record({ListCommand::BITMAP, {x, y, w, h, palette_size}, {}, pixels, palette, 0}); return; }
+        if (w <= 0 || h <= 0 || !pixels || !palette) return;
+        Uint32 table[256];
+        for (int i = 0; i < 256; i++) table[i] = i < palette_size ? palette[i].to_u32() : 0;
+
+        if (soft.enabled) {
+            static std::vector<u32> argb;
+            argb.resize((size_t)w * h);
+            indexed_to_argb(pixels, argb.data(), w * h, table);
+            soft_blit(x, y, w, h, argb.data());
+            return;
         }
-        return pressed;
+
+        // Converted straight into the streaming texture's memory
+        CachedSprite* s = sprite_entry(pixels, w, h, true);
+        if (!s) return;
+        void* locked;
+        int pitch;
+        if (SDL_LockTexture(s->texture, NULL, &locked, &pitch) != 0) return;
+        for (i32 row = 0; row < h; row++) {
+            indexed_to_argb(pixels + (size_t)row * w, (Uint32*)((Uint8*)locked + (size_t)row * pitch), w, table);
+        }
+        SDL_UnlockTexture(s->texture);
+        batch_image(s->texture, (float)x, (float)y, (float)(x + w), (float)(y + h));
     }
-    
-    float input_get_axis(AnalogAxis axis) {
-        const Uint8* k = SDL_GetKeyboardState(NULL);
-        float axis_val = 0.0f;
-
-        // Controller logic
-        if (pc.controller) {
-            SDL_GameControllerAxis sdl_axis;
-            switch (axis) {
-                case AXIS_LEFT_X:  sdl_axis = SDL_CONTROLLER_AXIS_LEFTX; break;
-                case AXIS_LEFT_Y:  sdl_axis = SDL_CONTROLLER_AXIS_LEFTY; break;
-                case AXIS_RIGHT_X: sdl_axis = SDL_CONTROLLER_AXIS_RIGHTX; break;
-                case AXIS_RIGHT_Y: sdl_axis = SDL_CONTROLLER_AXIS_RIGHTY; break;
-                default: return 0.0f;
+
+    static void replay_command(const DisplayListData& list, const ListCommand& c) {
+        const i32* v = c.v;
+        switch (c.kind) {
+            case ListCommand::CLEAR:    gfx_clear(c.color); break;
+            case ListCommand::RECT:     gfx_draw_rect(v[0], v[1], v[2], v[3], c.color); break;
+            case ListCommand::LINE:     gfx_draw_line(v[0], v[1], v[2], v[3], c.color); break;
+            case ListCommand::TRIANGLE: gfx_draw_triangle(v[0], v[1], v[2], v[3], v[4], v[5], c.color); break;
+            case ListCommand::CHAR:     gfx_draw_char(v[0], v[1], (char)v[2], c.color, v[3]); break;
+            case ListCommand::TEXT:     gfx_draw_text(v[0], v[1], list.text.c_str() + c.text, c.color, v[2]); break;
+            case ListCommand::SPRITE:   gfx_draw_sprite(v[0], v[1], v[2], v[3], (const u32*)c.data); break;
+            case ListCommand::BITMAP:   gfx_draw_indexed_bitmap(v[0], v[1], v[2], v[3], (const u8*)c.data, c.palette, v[4]); break;
+        }
+    }
+
+    static bool is_geometry(ListCommand::Kind kind) {
+        return kind == ListCommand::RECT || kind == ListCommand::LINE || kind == ListCommand::TRIANGLE ||
+               kind == ListCommand::CHAR || kind == ListCommand::TEXT;
+    }
+
+    // Runs the primitives once into the list's own arrays
+    static void compile_list(DisplayListData& list) {
+        batch = &list.geometry;
+        for (size_t i = 0; i < list.commands.size(); i++) {
+            const ListCommand& c = list.commands[i];
+            if (!is_geometry(c.kind)) {
+                list.steps.push_back({(int)i, 0, 0, 0, 0});
+                continue;
+            }
+            if (list.steps.empty() || list.steps.back().command != -1) {
+                list.steps.push_back({-1, (int)batch->vertices.size(), 0, (int)batch->indices.size(), 0});
             }
-            i16 val = SDL_GameControllerGetAxis(pc.controller, sdl_axis);
-            axis_val = val / 32767.0f;
-            if (axis_val > -0.1f && axis_val < 0.1f) axis_val = 0.0f;
+            replay_command(list, c);
+            DisplayListData::Step& step = list.steps.back();
+            step.vertex_count = (int)batch->vertices.size() - step.first_vertex;
+            step.index_count = (int)batch->indices.size() - step.first_index;
         }
+        batch = &frame_batch;
+        list.geometry.runs.clear();
+        list.compiled = true;
+    }
 
-        // Keyboard fallback/mixing
-        if (axis_val == 0.0f) {
-            switch (axis) {
-                case AXIS_LEFT_X: 
-                    if (k[SDL_SCANCODE_A] || k[SDL_SCANCODE_LEFT]) axis_val -= 1.0f;
-                    if (k[SDL_SCANCODE_D] || k[SDL_SCANCODE_RIGHT]) axis_val += 1.0f;
-                    break;
-                case AXIS_LEFT_Y:
-                    if (k[SDL_SCANCODE_W] || k[SDL_SCANCODE_UP]) axis_val -= 1.0f;
-                    if (k[SDL_SCANCODE_S] || k[SDL_SCANCODE_DOWN]) axis_val += 1.0f;
-                    break;
-                case AXIS_RIGHT_X:
-                    if (k[SDL_SCANCODE_J]) axis_val -= 1.0f;
-                    if (k[SDL_SCANCODE_L]) axis_val += 1.0f;
-                    break;
-                case AXIS_RIGHT_Y:
-                    if (k[SDL_SCANCODE_I]) axis_val -= 1.0f;
-                    if (k[SDL_SCANCODE_K]) axis_val += 1.0f;
-                    break;
+    DisplayList gfx_list_begin() {
+        if (recording) return 0; // No nesting
+        size_t slot = 0;
+        while (slot < lists.size() && lists[slot]) slot++;
+        if (slot == lists.size()) lists.emplace_back();
+        lists[slot].reset(new DisplayListData());
+        recording = lists[slot].get();
+        return (DisplayList)slot + 1;
+    }
+
+    void gfx_list_end() {
+        DisplayListData* list = recording;
+        if (!list) return;
+        recording = nullptr;
+        if (!soft.enabled) compile_list(*list);
+    }
+
+    void gfx_list_draw(DisplayList id) {
+        if (id == 0 || id > lists.size() || !lists[id - 1]) return;
+        const DisplayListData& list = *lists[id - 1];
+        if (recording) {
+            if (&list == recording) return;
+            for (ListCommand c : list.commands) {
+                if (c.kind == ListCommand::TEXT) {
+                    size_t offset = recording->text.size();
+                    recording->text.append(list.text.c_str() + c.text);
+                    recording->text.push_back('\0');
+                    c.text = offset;
+                }
+                record(c);
+            }
+            return;
+        }
+        if (!list.compiled) {
+            for (const ListCommand& c : list.commands) replay_command(list, c);
+            return;
+        }
+        for (const DisplayListData::Step& step : list.steps) {
+            if (step.command >= 0) {
+                replay_command(list, list.commands[step.command]);
+                continue;
             }
+            batch_use(atlas);
+            int offset = (int)batch->vertices.size() - step.first_vertex;
+            const SDL_Vertex* vertices = list.geometry.vertices.data() + step.first_vertex;
+            batch->vertices.insert(batch->vertices.end(), vertices, vertices + step.vertex_count);
+            const int* indices = list.geometry.indices.data() + step.first_index;
+            for (int i = 0; i < step.index_count; i++) batch->indices.push_back(indices[i] + offset);
+        }
+    }
+
+    void gfx_list_free(DisplayList id) {
+        if (id == 0 || id > lists.size() || !lists[id - 1] || lists[id - 1].get() == recording) return;
+        lists[id - 1].reset();
+    }
+
+    void gfx_end_frame() {
+        if (soft.enabled) {
+            SDL_UpdateTexture(soft.texture, NULL, soft.pixels.data(), SCREEN_W * sizeof(Uint32));
+            SDL_RenderCopy(pc.renderer, soft.texture, NULL, NULL);
+            if (preview.is_open()) preview.present(soft.pixels.data(), SCREEN_W, SCREEN_H);
+        } else {
+            batch_flush();
+            sprite_cache_trim();
+        }
+        if (!soft.enabled && preview.ready()) {
+            // Read back before the flip; the back buffer is undefined after it.
+            // Skipped while the studio is still taking the last frame: each
+            // readback stalls the GPU pipeline.
+            int w, h;
+            SDL_GetRendererOutputSize(pc.renderer, &w, &h);
+            preview_pixels.resize((size_t)w * h);
+            if (SDL_RenderReadPixels(pc.renderer, NULL, SDL_PIXELFORMAT_ARGB8888, preview_pixels.data(), w * sizeof(Uint32)) == 0) {
+                preview.present(preview_pixels.data(), w, h);
+            }
+        }
+        Uint64 drawn = SDL_GetPerformanceCounter();
+        pacer.stats.cpu_ms = (float)(drawn - pacer.frame_start) * 1000.0f / pacer.freq;
+
+        if (drawn >= pacer.deadline + pacer.period) {
+            // Missed whole periods: skip their presents, keep their updates
+            Uint64 missed = (drawn - pacer.deadline) / pacer.period;
+            pacer.stats.dropped += (u32)missed;
+            pacer.pending += (u32)missed;
+            pacer.deadline += missed * pacer.period;
+        }
+        pacer_wait(pacer.deadline);
+
+        Uint64 before = SDL_GetPerformanceCounter();
+        SDL_RenderPresent(pc.renderer);
+        pacer.stats.present_ms = (float)(SDL_GetPerformanceCounter() - before) * 1000.0f / pacer.freq;
+        pacer.deadline += pacer.period;
+    }
+
+    bool input_is_down(Button btn, int player) {
+        if (player < 0 || player >= INPUT_MAX_PLAYERS) return false;
+        return input.players[player].curr & btn;
+    }
+
+    bool input_just_pressed(Button btn, int player) {
+        if (player < 0 || player >= INPUT_MAX_PLAYERS) return false;
+        const PlayerInput& p = input.players[player];
+        return (p.curr & btn) && !(p.prev & btn);
+    }
+
+    u64 input_pressed_at(Button btn, int player) {
+        if (player < 0 || player >= INPUT_MAX_PLAYERS) return 0;
+        for (int b = 0; b < 8; b++) {
+            if (btn == (1 << b)) return input.players[player].pressed_at[b];
+        }
+        return 0;
+    }
+
+    float input_get_axis(AnalogAxis axis, int player) {
+        if (player < 0 || player >= INPUT_MAX_PLAYERS || axis < AXIS_LEFT_X || axis > AXIS_RIGHT_Y) return 0.0f;
+        float axis_val = input.players[player].axes[axis];
+        if (axis_val != 0.0f || player != 0) return axis_val;
+
+        // Keyboard fallback for player 0
+        const bool* k = input.keys;
+        switch (axis) {
+            case AXIS_LEFT_X:
+                if (k[SDL_SCANCODE_A] || k[SDL_SCANCODE_LEFT]) axis_val -= 1.0f;
+                if (k[SDL_SCANCODE_D] || k[SDL_SCANCODE_RIGHT]) axis_val += 1.0f;
+                break;
+            case AXIS_LEFT_Y:
+                if (k[SDL_SCANCODE_W] || k[SDL_SCANCODE_UP]) axis_val -= 1.0f;
+                if (k[SDL_SCANCODE_S] || k[SDL_SCANCODE_DOWN]) axis_val += 1.0f;
+                break;
+            case AXIS_RIGHT_X:
+                if (k[SDL_SCANCODE_J]) axis_val -= 1.0f;
+                if (k[SDL_SCANCODE_L]) axis_val += 1.0f;
+                break;
+            case AXIS_RIGHT_Y:
+                if (k[SDL_SCANCODE_I]) axis_val -= 1.0f;
+                if (k[SDL_SCANCODE_K]) axis_val += 1.0f;
+                break;
         }
         return axis_val;
     }
-    
-    // Simple state tracking for just_pressed
-    static u8 prev_input = 0;
-    static u8 curr_input = 0;
-    
+
     void update_input_state() {
-        SDL_Event event;
-        while (SDL_PollEvent(&event)) {
-            if (event.type == SDL_QUIT) pc.running = false;
+        // Events were drained in gfx_begin_frame; this only latches them,
+        // so extra catch-up updates in one frame see no new presses. A tap
+        // released before the update still shows as held for one snapshot.
+        u8 keys = 0;
+        for (int b = 0; b < 8; b++) {
+            if (input.keys[KEY_BUTTONS[b]]) keys |= (u8)(1 << b);
+        }
+        for (int i = 0; i < INPUT_MAX_PLAYERS; i++) {
+            PlayerInput& p = input.players[i];
+            p.prev = p.curr;
+            p.curr = p.pad | (i == 0 ? keys : 0) | p.latched;
+            p.latched = 0;
         }
+    }
+}
+
+#ifdef ZENU_HOT_RELOAD
+#include <dlfcn.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fstream>
+#include <string>
+#include <cstring>
+
+// Hot-reload host: the game lives in a shared library (-fPIC -shared) that
+// resolves engine calls against this executable (-rdynamic). When the file
+// changes it is swapped in between frames; the window, audio device and
+// every other bit of backend state stay as they are.
+struct GameLib {
+    void* handle = nullptr;
+    void (*init)() = nullptr;
+    void (*update)() = nullptr;
+    void (*draw)() = nullptr;
+    void* (*hot_state)(zenu::u32*) = nullptr;
+};
+
+static bool load_game(const std::string& path, int generation, GameLib& lib) {
+    // dlopen() hands back the cached image for a path it has seen, so each
+    // generation is loaded from its own copy (removed once mapped)
+    std::string copy = path + "." + std::to_string(generation);
+    {
+        std::ifstream src(path, std::ios::binary);
+        std::ofstream dst(copy, std::ios::binary);
+        if (!src || !dst) return false;
+        dst << src.rdbuf();
+    }
+    lib.handle = dlopen(copy.c_str(), RTLD_NOW | RTLD_LOCAL);
+    unlink(copy.c_str());
+    if (!lib.handle) {
+        std::cerr << "Hot reload: " << dlerror() << std::endl;
+        return false;
+    }
+    lib.init = (void (*)())dlsym(lib.handle, "game_init");
+    lib.update = (void (*)())dlsym(lib.handle, "game_update");
+    lib.draw = (void (*)())dlsym(lib.handle, "game_draw");
+    lib.hot_state = (void* (*)(zenu::u32*))dlsym(lib.handle, "game_hot_state");
+    if (!lib.init || !lib.update || !lib.draw) {
+        std::cerr << "Hot reload: " << path << " is missing game_init/update/draw" << std::endl;
+        dlclose(lib.handle);
+        return false;
+    }
+    return true;
+}
 
-        prev_input = curr_input;
-        curr_input = 0;
-        if (input_is_down(BUTTON_UP))     curr_input |= BUTTON_UP;
-        if (input_is_down(BUTTON_DOWN))   curr_input |= BUTTON_DOWN;
-        if (input_is_down(BUTTON_LEFT))   curr_input |= BUTTON_LEFT;
-        if (input_is_down(BUTTON_RIGHT))  curr_input |= BUTTON_RIGHT;
-        if (input_is_down(BUTTON_A))      curr_input |= BUTTON_A;
-        if (input_is_down(BUTTON_B))      curr_input |= BUTTON_B;
-        if (input_is_down(BUTTON_START))  curr_input |= BUTTON_START;
-        if (input_is_down(BUTTON_SELECT)) curr_input |= BUTTON_SELECT;
+// Sprite and bitmap commands in a display list point at game memory
+static bool lists_hold_pointers() {
+    for (const std::unique_ptr<DisplayListData>& list : lists) {
+        if (!list) continue;
+        for (const ListCommand& c : list->commands) {
+            if (c.kind == ListCommand::SPRITE || c.kind == ListCommand::BITMAP) return true;
+        }
     }
+    return false;
+}
+
+// mtime alone has one-second resolution; the rename gives every build a
+// new inode, so two builds within the same second still differ
+struct FileStamp {
+    ino_t ino = 0;
+    time_t mtime = 0;
+    bool operator!=(const FileStamp& o) const { return ino != o.ino || mtime != o.mtime; }
+};
 
-    bool input_just_pressed(Button btn) {
-        return (curr_input & btn) && !(prev_input & btn);
+static FileStamp file_stamp(const std::string& path) {
+    struct stat st;
+    FileStamp stamp;
+    if (stat(path.c_str(), &st) == 0) {
+        stamp.ino = st.st_ino;
+        stamp.mtime = st.st_mtime;
     }
+    return stamp;
 }
 
+int main(int argc, char** argv) {
+    std::string path = argc > 1 ? argv[1] : "build/libgame.so";
+    zenu::gfx_init();
+
+    GameLib game;
+    int generation = 0;
+    if (!load_game(path, generation, game)) return 1;
+    FileStamp stamp = file_stamp(path);
+    game.init();
+
+    zenu::u32 frame = 0;
+    while (pc.running) {
+        // The build writes the library under a temporary name and renames
+        // it, so a new stamp always means a complete file
+        if (++frame % 15 == 0 && file_stamp(path) != stamp) {
+            stamp = file_stamp(path);
+            GameLib next;
+            if (load_game(path, ++generation, next)) {
+                std::vector<zenu::u8> saved;
+                zenu::u32 size = 0;
+                if (game.hot_state) {
+                    zenu::u8* p = (zenu::u8*)game.hot_state(&size);
+                    saved.assign(p, p + size);
+                }
+                dlclose(game.handle);
+                game = next;
+                sprite_cache_clear(); // Keyed by pointers into the old library
+
+                // Kept state may hold list handles, so lists survive with it,
+                // unless they point into the old library too
+                zenu::u32 next_size = 0;
+                void* dst = game.hot_state ? game.hot_state(&next_size) : nullptr;
+                if (dst && !saved.empty() && next_size == saved.size() && !lists_hold_pointers()) {
+                    std::memcpy(dst, saved.data(), next_size);
+                    std::cout << "Hot reload: game code swapped, state kept" << std::endl;
+                } else {
+                    lists.clear();
+                    game.init();
+                    std::cout << "Hot reload: game code swapped, restarted" << std::endl;
+                }
+            }
+        }
+
+        zenu::gfx_begin_frame();
+        for (zenu::u32 i = 0; i < zenu::frame_stats().updates; i++) {
+            zenu::update_input_state();
+            game.update();
+        }
+        game.draw();
+        zenu::gfx_end_frame();
+    }
+    return 0;
+}
+#else
 int main() {
     zenu::gfx_init();
     ::game_init();
     while (pc.running) {
         zenu::gfx_begin_frame();
-        zenu::update_input_state();
-        ::game_update();
+        for (zenu::u32 i = 0; i < zenu::frame_stats().updates; i++) {
+            zenu::update_input_state();
+            ::game_update();
+        }
         ::game_draw();
         zenu::gfx_end_frame();
     }
     return 0;
 }
 #endif
+#endif
@@ -7,32 +7,119 @@ namespace zenu {
     volatile u32* const INPUT_REGS  = (volatile u32*)0x02000000;
     volatile f32* const ANALOG_REGS = (volatile f32*)0x02000010; // LX, LY, RX, RY
     volatile f32* const APU_REGS    = (volatile f32*)0x02000100;
+
+    // Interrupt Controller
+    volatile u32* const REG_IRQ_PENDING = (volatile u32*)0x02000200; // Write 1 to ack
+    volatile u32* const REG_IRQ_ENABLE  = (volatile u32*)0x02000204;
+    const u32 IRQ_VBLANK = 1 << 0;
+    const u32 MIE_MEIE   = 1 << 11;
+
+    // Counters (Zicsr), split into halves on RV32. Re-read the high half to
+    // catch a carry out of the low half between the two reads.
+    #define ZENU_READ_CSR64(lo, hi) \
+        u32 h, l, h2; \
+        do { \
+            asm volatile("csrr %0, " #hi : "=r"(h)); \
+            asm volatile("csrr %0, " #lo : "=r"(l)); \
+            asm volatile("csrr %0, " #hi : "=r"(h2)); \
+        } while (h != h2); \
+        return ((u64)h << 32) | l;
+
+    u64 time_us()      { ZENU_READ_CSR64(time, timeh) }
+    u64 time_cycles()  { ZENU_READ_CSR64(cycle, cycleh) }
+    u64 time_instret() { ZENU_READ_CSR64(instret, instreth) }
     
-    // GPU Registers
-    volatile u32* const REG_GPU_CMD   = (volatile u32*)0x03000000;
-    volatile u32* const REG_GPU_COLOR = (volatile u32*)0x03000004;
-    volatile i16* const REG_GPU_X1    = (volatile i16*)0x03000008;
-    volatile i16* const REG_GPU_Y1    = (volatile i16*)0x0300000A;
-    volatile i16* const REG_GPU_X2    = (volatile i16*)0x0300000C;
-    volatile i16* const REG_GPU_Y2    = (volatile i16*)0x0300000E;
-    volatile i16* const REG_GPU_X3    = (volatile i16*)0x03000010;
-    volatile i16* const REG_GPU_Y3    = (volatile i16*)0x03000012;
+    // GPU: framebuffer at the start of VRAM (mode 0), command port in the
+    // control block at VRAM + 0xFF0000 (mode 2). The GPU scans out one mode
+    // per frame, so primitives and CPU blits can't share a frame; clears
+    // and blits write the framebuffer directly.
+    volatile u32* const FRAMEBUFFER   = (volatile u32*)0x03000000;
+    const i32 FB_WIDTH = 160;
+    const i32 FB_HEIGHT = 144;
+    volatile u32* const REG_GPU_CMD   = (volatile u32*)0x03FF0020;
+    volatile i16* const REG_GPU_X1    = (volatile i16*)0x03FF0024;
+    volatile i16* const REG_GPU_Y1    = (volatile i16*)0x03FF0026;
+    volatile i16* const REG_GPU_X2    = (volatile i16*)0x03FF0028;
+    volatile i16* const REG_GPU_Y2    = (volatile i16*)0x03FF002A;
+    volatile i16* const REG_GPU_X3    = (volatile i16*)0x03FF002C;
+    volatile i16* const REG_GPU_Y3    = (volatile i16*)0x03FF002E;
+    volatile u32* const REG_GPU_COLOR = (volatile u32*)0x03FF0030;
+
+    // One game_update() per vblank; time_us() only feeds the stats
+    static FrameStats stats;
+    static u64 frame_start;
+
+    void frame_set_rate(u32) {}
+    float frame_dt() { return 1.0f / 60.0f; }
+    FrameStats frame_stats() { return stats; }
 
     void gfx_init() {
-        // Zenu hardware doesn't need init
+        // Route vblank to the CPU. mstatus.MIE stays clear, so WFI wakes on it
+        // without needing a trap handler.
+        *REG_IRQ_PENDING = IRQ_VBLANK;
+        *REG_IRQ_ENABLE = IRQ_VBLANK;
+        asm volatile("csrs mie, %0" :: "r"(MIE_MEIE));
     }
     
     void gfx_begin_frame() {
-        // Wait for VSync not implemented in simple emulator
+        // Sleep until VSync (returns at once if we already missed one)
+        if (*REG_IRQ_PENDING & IRQ_VBLANK) stats.dropped++;
+        asm volatile("wfi");
+        *REG_IRQ_PENDING = IRQ_VBLANK;
+        frame_start = time_us();
+        stats.updates = 1;
     }
     
     void gfx_end_frame() {
         // Swap buffers handled by hardware
+        stats.cpu_ms = (float)(time_us() - frame_start) / 1000.0f;
+        stats.present_ms = 0.0f;
     }
     
+    // Display lists: a recorded list is the exact sequence of GPU port
+    // writes (rects and text already broken into triangles) kept in a
+    // static pool in RAM, so a replay just streams it back out. Sprites
+    // and bitmaps are CPU blits and stay calls. Lists are packed in the
+    // pool in recording order; freeing one slides the later ones down. A
+    // list that ran out of pool space is never drawn, rather than drawn
+    // in part.
+    enum : u32 { CMD_CLEAR = 0, CMD_LINE = 1, CMD_TRIANGLE = 2, CMD_SPRITE = 0x100, CMD_BITMAP = 0x101 };
+    struct GpuCommand {
+        u32 cmd;
+        u32 color;
+        i16 xy[6];
+        const void* data;
+        const Color* palette;
+    };
+    const u32 LIST_POOL = 4096;
+    const u32 MAX_LISTS = 32;
+    struct ListRange {
+        u32 first, count;
+        bool used;
+        bool truncated; // Pool filled up while recording
+    };
+    static GpuCommand list_pool[LIST_POOL];
+    static ListRange list_ranges[MAX_LISTS];
+    static u32 pool_used;
+    static ListRange* recording;
+
+    static void gpu_submit(const GpuCommand& c);
+
+    static void gpu_emit(u32 cmd, u32 color, i32 x1, i32 y1, i32 x2, i32 y2, i32 x3, i32 y3,
+                         const void* data = nullptr, const Color* palette = nullptr) {
+        GpuCommand c = {cmd, color, {(i16)x1, (i16)y1, (i16)x2, (i16)y2, (i16)x3, (i16)y3}, data, palette};
+        if (!recording) {
+            gpu_submit(c);
+        } else if (pool_used < LIST_POOL) {
+            list_pool[pool_used++] = c;
+            recording->count++;
+        } else {
+            recording->truncated = true;
+        }
+    }
+
     void gfx_clear(Color color) {
-        REG_GPU_COLOR = color.to_u32();
-        REG_GPU_CMD = 0; // CLEAR
+        gpu_emit(CMD_CLEAR, color.to_u32(), 0, 0, 0, 0, 0, 0);
     }
     
     void gfx_draw_rect(i32 x, i32 y, i32 w, i32 h, Color color) {
@@ -42,65 +129,188 @@ namespace zenu {
     }
     
     void gfx_draw_line(i32 x1, i32 y1, i32 x2, i32 y2, Color color) {
-        REG_GPU_COLOR = color.to_u32();
-        REG_GPU_X1 = (i16)x1; REG_GPU_Y1 = (i16)y1;
-        REG_GPU_X2 = (i16)x2; REG_GPU_Y2 = (i16)y2;
-        REG_GPU_CMD = 1; // DRAW_LINE
+        gpu_emit(CMD_LINE, color.to_u32(), x1, y1, x2, y2, 0, 0);
     }
 
     void gfx_draw_triangle(i32 x1, i32 y1, i32 x2, i32 y2, i32 x3, i32 y3, Color color) {
-        REG_GPU_COLOR = color.to_u32();
-        REG_GPU_X1 = (i16)x1; REG_GPU_Y1 = (i16)y1;
-        REG_GPU_X2 = (i16)x2; REG_GPU_Y2 = (i16)y2;
-        REG_GPU_X3 = (i16)x3; REG_GPU_Y3 = (i16)y3;
-        REG_GPU_CMD = 2; // DRAW_TRIANGLE
+        gpu_emit(CMD_TRIANGLE, color.to_u32(), x1, y1, x2, y2, x3, y3);
+    }
+
+    void gfx_draw_triangles(const Vertex* v, i32 count) {
+        for (i32 i = 0; i + 2 < count; i += 3) {
+            gfx_draw_triangle(v[i].x, v[i].y, v[i + 1].x, v[i + 1].y, v[i + 2].x, v[i + 2].y, v[i].color);
+        }
+    }
+
+    void gfx_draw_sprite(i32 x, i32 y, i32 w, i32 h, const u32* data) {
+        // Blit into the framebuffer; alpha 0 is transparent, anything else opaque
+        if (w <= 0 || h <= 0 || !data) return;
+        if (recording) {
+            gpu_emit(CMD_SPRITE, 0, x, y, w, h, 0, 0, data);
+            return;
+        }
+        i32 x0 = x < 0 ? 0 : x, x1 = x + w > FB_WIDTH ? FB_WIDTH : x + w;
+        i32 y0 = y < 0 ? 0 : y, y1 = y + h > FB_HEIGHT ? FB_HEIGHT : y + h;
+        for (i32 row = y0; row < y1; row++) {
+            const u32* src = data + (row - y) * w - x;
+            volatile u32* dst = FRAMEBUFFER + row * FB_WIDTH;
+            for (i32 col = x0; col < x1; col++) {
+                if (src[col] >> 24) dst[col] = src[col];
+            }
+        }
+    }
+
+    void gfx_draw_indexed_bitmap(i32 x, i32 y, i32 w, i32 h, const u8* pixels, const Color* palette, i32 palette_size) {
+        // Same blit as a sprite, through a table built once per call
+        if (w <= 0 || h <= 0 || !pixels || !palette) return;
+        if (recording) {
+            gpu_emit(CMD_BITMAP, 0, x, y, w, h, palette_size, 0, pixels, palette);
+            return;
+        }
+        u32 table[256];
+        for (i32 i = 0; i < 256; i++) table[i] = i < palette_size ? palette[i].to_u32() : 0;
+        i32 x0 = x < 0 ? 0 : x, x1 = x + w > FB_WIDTH ? FB_WIDTH : x + w;
+        i32 y0 = y < 0 ? 0 : y, y1 = y + h > FB_HEIGHT ? FB_HEIGHT : y + h;
+        for (i32 row = y0; row < y1; row++) {
+            const u8* src = pixels + (row - y) * w - x;
+            volatile u32* dst = FRAMEBUFFER + row * FB_WIDTH;
+            for (i32 col = x0; col < x1; col++) {
+                u32 c = table[src[col]];
+                if (c >> 24) dst[col] = c;
+            }
+        }
     }
 
-    void gfx_draw_char(i32 x, i32 y, char c, Color color) {
-        if (c < 32 || c > 127) return;
+    void gfx_draw_char(i32 x, i32 y, char c, Color color, i32 scale) {
+        if (c < 32 || c > 127 || scale <= 0) return;
         const u8* glyph = font_8x8[c - 32];
         for (int row = 0; row < 8; row++) {
             for (int col = 0; col < 8; col++) {
                 if (glyph[row] & (0x80 >> col)) {
-                    gfx_draw_rect(x + col, y + row, 1, 1, color);
+                    gfx_draw_rect(x + col * scale, y + row * scale, scale, scale, color);
                 }
             }
         }
     }
 
-    void gfx_draw_text(i32 x, i32 y, const char* text, Color color) {
+    void gfx_draw_text(i32 x, i32 y, const char* text, Color color, i32 scale) {
         int cx = x;
         while (*text) {
             if (*text == '\n') {
-                y += 9;
+                y += 9 * scale;
                 cx = x;
             } else {
-                gfx_draw_char(cx, y, *text, color);
-                cx += 8;
+                gfx_draw_char(cx, y, *text, color, scale);
+                cx += 8 * scale;
             }
             text++;
         }
     }
 
-    // Input
-    static u8 prev_input = 0;
-    static u8 curr_input = 0;
+    static void gpu_submit(const GpuCommand& c) {
+        const i16* v = c.xy;
+        if (c.cmd == CMD_CLEAR) {
+            // The command port has no clear (cmd 0 is "no command")
+            for (i32 i = 0; i < FB_WIDTH * FB_HEIGHT; i++) FRAMEBUFFER[i] = c.color;
+        } else if (c.cmd == CMD_SPRITE) {
+            gfx_draw_sprite(v[0], v[1], v[2], v[3], (const u32*)c.data);
+        } else if (c.cmd == CMD_BITMAP) {
+            gfx_draw_indexed_bitmap(v[0], v[1], v[2], v[3], (const u8*)c.data, c.palette, v[4]);
+        } else {
+            *REG_GPU_COLOR = c.color;
+            *REG_GPU_X1 = v[0]; *REG_GPU_Y1 = v[1];
+            *REG_GPU_X2 = v[2]; *REG_GPU_Y2 = v[3];
+            *REG_GPU_X3 = v[4]; *REG_GPU_Y3 = v[5];
+            *REG_GPU_CMD = c.cmd;
+        }
+    }
+
+    DisplayList gfx_list_begin() {
+        if (recording) return 0; // No nesting
+        for (u32 i = 0; i < MAX_LISTS; i++) {
+            if (!list_ranges[i].used) {
+                list_ranges[i] = {pool_used, 0, true, false};
+                recording = &list_ranges[i];
+                return i + 1;
+            }
+        }
+        return 0;
+    }
+
+    void gfx_list_end() {
+        recording = nullptr;
+    }
+
+    void gfx_list_draw(DisplayList id) {
+        if (id == 0 || id > MAX_LISTS || !list_ranges[id - 1].used) return;
+        const ListRange& list = list_ranges[id - 1];
+        if (&list == recording) return;
+        if (list.truncated) {
+            if (recording) recording->truncated = true; // Would inherit the gap
+            return;
+        }
+        // While recording, another list's commands are copied in
+        for (u32 i = 0; i < list.count; i++) {
+            const GpuCommand& c = list_pool[list.first + i];
+            if (recording) gpu_emit(c.cmd, c.color, c.xy[0], c.xy[1], c.xy[2], c.xy[3], c.xy[4], c.xy[5], c.data, c.palette);
+            else gpu_submit(c);
+        }
+    }
+
+    // Kept as a plain loop: with -nostdlib there is no memmove to call
+    __attribute__((optimize("no-tree-loop-distribute-patterns")))
+    void gfx_list_free(DisplayList id) {
+        if (id == 0 || id > MAX_LISTS || &list_ranges[id - 1] == recording) return;
+        ListRange& list = list_ranges[id - 1];
+        if (!list.used) return;
+        list.used = false;
+        // Close the gap; replay only goes through first and count
+        for (u32 i = list.first + list.count; i < pool_used; i++) list_pool[i - list.count] = list_pool[i];
+        pool_used -= list.count;
+        for (u32 i = 0; i < MAX_LISTS; i++) {
+            if (list_ranges[i].used && list_ranges[i].first > list.first) list_ranges[i].first -= list.count;
+        }
+    }
+
+    // Input: one joypad byte per port, latched once per update
+    const int PORTS = 2;
+    static u8 prev_input[PORTS];
+    static u8 curr_input[PORTS];
+    static u64 pressed_at[PORTS][8];
 
     void update_input_state() {
-        prev_input = curr_input;
-        curr_input = (u8)(*INPUT_REGS); 
+        u32 joy = *INPUT_REGS;
+        u64 now = time_us();
+        for (int p = 0; p < PORTS; p++) {
+            prev_input[p] = curr_input[p];
+            curr_input[p] = (u8)(joy >> (8 * p));
+            u8 pressed = curr_input[p] & ~prev_input[p];
+            for (int b = 0; b < 8; b++) {
+                if (pressed & (1 << b)) pressed_at[p][b] = now;
+            }
+        }
     }
 
-    bool input_just_pressed(Button btn) {
-        return (curr_input & btn) && !(prev_input & btn);
+    bool input_just_pressed(Button btn, int player) {
+        if (player < 0 || player >= PORTS) return false;
+        return (curr_input[player] & btn) && !(prev_input[player] & btn);
     }
     
-    bool input_is_down(Button btn) {
-        return curr_input & btn;
+    bool input_is_down(Button btn, int player) {
+        if (player < 0 || player >= PORTS) return false;
+        return curr_input[player] & btn;
     }
 
-    float input_get_axis(AnalogAxis axis) {
-        if (axis < 0 || axis > 3) return 0.0f;
+    u64 input_pressed_at(Button btn, int player) {
+        if (player < 0 || player >= PORTS) return 0;
+        for (int b = 0; b < 8; b++) {
+            if (btn == (1 << b)) return pressed_at[player][b];
+        }
+        return 0;
+    }
+
+    float input_get_axis(AnalogAxis axis, int player) {
+        if (player != 0 || axis < 0 || axis > 3) return 0.0f;
         return ANALOG_REGS[axis];
     }
     
@@ -117,6 +327,10 @@ namespace zenu {
         volatile f32* ch = APU_REGS + (channel * 4);
         ch[1] = 0.0f; // Vol 0
     }
+
+    void audio_set_envelope(int, float, float, float, float) {
+        // The APU has no envelope generator
+    }
 }
 
 // Entry Point
@@ -125,11 +339,12 @@ extern "C" void _start() {
     ::game_init();
     
     while (true) {
+        zenu::gfx_begin_frame();
         zenu::update_input_state();
         ::game_update();
         zenu::gfx_clear(zenu::Color::from_rgba(0,0,0)); // Prevent trails if user forgets
         ::game_draw();
-        // VSync/Swap is implicit in hardware
+        zenu::gfx_end_frame(); // Swap is implicit in hardware
     }
 }
 #endif
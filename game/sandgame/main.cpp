@@ -31,8 +31,9 @@ int brush_size = 2;
 int frames = 0;
 
 // --- Colors ---
-Color get_particle_color(ParticleType type, int x, int y) {
-    int v = (x * 7 + y * 13) % 30; // Variation
+int color_variation(int x, int y) { return (x * 7 + y * 13) % 30; }
+
+Color particle_color(ParticleType type, int v) {
     switch (type) {
         case SAND:  return Color::from_rgba(220 - v, 180 - v, 100 - v);
         case WATER: return Color::from_rgba(30, 80 + v, 200 + v/2, 180);
@@ -44,6 +45,28 @@ Color get_particle_color(ParticleType type, int x, int y) {
     }
 }
 
+Color get_particle_color(ParticleType type, int x, int y) {
+    return particle_color(type, color_variation(x, y));
+}
+
+// --- Rendering ---
+// The grid is drawn as one indexed bitmap. Every (type, variation) pair
+// gets a palette slot, so the per-cell work is a table lookup.
+const int VARIATIONS = 30;
+Color palette[256];
+u8 variation[GRID_H][GRID_W];
+u8 frame_pixels[GRID_H][GRID_W];
+
+void build_palette() {
+    for (int t = SAND; t <= OIL; t++) {
+        for (int v = 0; v < VARIATIONS; v++) {
+            palette[1 + (t - 1) * VARIATIONS + v] = particle_color((ParticleType)t, v);
+        }
+    }
+    for (int y = 0; y < GRID_H; y++)
+        for (int x = 0; x < GRID_W; x++) variation[y][x] = (u8)color_variation(x, y);
+}
+
 // --- Physics Helpers ---
 bool in_bounds(int x, int y) { return x >= 0 && x < GRID_W && y >= 0 && y < GRID_H; }
 bool is_empty(int x, int y) { return in_bounds(x, y) && grid[y][x] == EMPTY; }
@@ -155,6 +178,8 @@ void place_particles(int cx, int cy, ParticleType type, int size) {
 
 // --- Engine Hooks ---
 void game_init() {
+    build_palette();
+
     // Clear grid
     for (int y = 0; y < GRID_H; y++)
         for (int x = 0; x < GRID_W; x++) grid[y][x] = EMPTY;
@@ -238,15 +263,14 @@ void game_draw() {
         return;
     }
 
-    // Draw all particles
+    // Draw all particles (slot 0 is transparent, so empty cells show the clear color)
     for (int y = 0; y < GRID_H; y++) {
         for (int x = 0; x < GRID_W; x++) {
-            if (grid[y][x] != EMPTY) {
-                Color c = get_particle_color((ParticleType)grid[y][x], x, y);
-                gfx_draw_rect(x, y, 1, 1, c);
-            }
+            u8 t = grid[y][x];
+            frame_pixels[y][x] = t == EMPTY ? 0 : (u8)(1 + (t - 1) * VARIATIONS + variation[y][x]);
         }
     }
+    gfx_draw_indexed_bitmap(0, 0, GRID_W, GRID_H, &frame_pixels[0][0], palette);
 
     // Draw cursor
     Color cursorColor = get_particle_color(brush, cursor_x, cursor_y);
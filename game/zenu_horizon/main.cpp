@@ -65,7 +65,7 @@ void game_init() {
 }
 
 void game_update() {
-    time_f += 0.016f;
+    time_f += frame_dt();
 
     // Movement axes
     float lx = input_get_axis(AXIS_LEFT_X);
@@ -85,14 +85,20 @@ void game_update() {
 }
 
 void draw_sky() {
-    // Atmospheric Scattering Sky Gradient
-    for (int y = 0; y < H / 2; y++) {
-        float t = (float)y / (H / 2);
-        u8 r = (u8)(80 + t * 40);
-        u8 g = (u8)(120 + t * 60);
-        u8 b = (u8)(200 + t * 55);
-        gfx_draw_rect(0, y, W, 1, Color::from_rgba(r, g, b));
+    // Atmospheric Scattering Sky Gradient (never changes: recorded once)
+    static DisplayList sky = 0;
+    if (!sky) {
+        sky = gfx_list_begin();
+        for (int y = 0; y < H / 2; y++) {
+            float t = (float)y / (H / 2);
+            u8 r = (u8)(80 + t * 40);
+            u8 g = (u8)(120 + t * 60);
+            u8 b = (u8)(200 + t * 55);
+            gfx_draw_rect(0, y, W, 1, Color::from_rgba(r, g, b));
+        }
+        gfx_list_end();
     }
+    gfx_list_draw(sky);
 
     // Realistic Sun with Glow
     V3 sun_pos = {50, 40, 100};
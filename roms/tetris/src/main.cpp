@@ -97,6 +97,7 @@ void clear_lines() {
 
 int main() {
     zenu_set_mode(0); // Pixel mode for simplicity for now
+    zenu_enable_vblank();
     
     int frame = 0;
     while (1) {
@@ -131,8 +132,7 @@ int main() {
         render();
         frame++;
         
-        // Simple delay loop
-        for(volatile int i=0; i<100000; i++);
+        zenu_wait_vblank();
     }
     return 0;
 }
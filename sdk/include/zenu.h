@@ -12,6 +12,19 @@
 #define GPU_REG_SCROLL_Y (GPU_CTRL + 0x08)
 #define GPU_REG_MODE     (GPU_CTRL + 0x0C)
 
+#define JOY1        0x02000000 // Player 1 buttons (bit 0 Up .. bit 7 Select)
+#define JOY2        0x02000001 // Player 2 buttons
+
+#define IRQ_PENDING 0x02000200 // Write 1 to acknowledge
+#define IRQ_ENABLE  0x02000204
+#define IRQ_VBLANK  (1u << 0)
+
+#define TIMER_MTIME    0x02000300 // 64-bit, microseconds (read-only)
+#define TIMER_MTIMECMP 0x02000308 // 64-bit, raises mip.MTIP when mtime >= mtimecmp
+
+#define APU_BASE    0x02000100
+#define APU_REG_PAN (APU_BASE + 0x10) // 1 byte per channel: 0=L, 128=C, 255=R
+
 // Helper to write to VRAM
 inline void zenu_set_mode(uint32_t mode) {
     *(volatile uint32_t*)GPU_REG_MODE = mode;
@@ -22,4 +35,46 @@ inline void zenu_draw_pixel(int x, int y, uint32_t color) {
     vram[y * 320 + x] = color;
 }
 
+// Enables the vblank line for zenu_wait_vblank(). Interrupts stay globally
+// disabled, so WFI simply resumes when the line goes high.
+inline void zenu_enable_vblank() {
+    *(volatile uint32_t*)IRQ_PENDING = IRQ_VBLANK;
+    *(volatile uint32_t*)IRQ_ENABLE = IRQ_VBLANK;
+    asm volatile("csrs mie, %0" :: "r"(1u << 11));
+}
+
+// Sleeps until the next vblank instead of spinning
+inline void zenu_wait_vblank() {
+    asm volatile("wfi");
+    *(volatile uint32_t*)IRQ_PENDING = IRQ_VBLANK;
+}
+
+// Counters: cycles at 30 MHz, time in microseconds, retired instructions
+#define ZENU_DEFINE_COUNTER(name, lo, hi) \
+    inline uint64_t name() { \
+        uint32_t h, l, h2; \
+        do { \
+            asm volatile("csrr %0, " #hi : "=r"(h)); \
+            asm volatile("csrr %0, " #lo : "=r"(l)); \
+            asm volatile("csrr %0, " #hi : "=r"(h2)); \
+        } while (h != h2); \
+        return ((uint64_t)h << 32) | l; \
+    }
+
+ZENU_DEFINE_COUNTER(zenu_rdcycle, cycle, cycleh)
+ZENU_DEFINE_COUNTER(zenu_rdtime, time, timeh)
+ZENU_DEFINE_COUNTER(zenu_rdinstret, instret, instreth)
+
+// Arms the timer interrupt (mie.MTIE) for an absolute mtime deadline
+inline void zenu_set_timer(uint64_t deadline_us) {
+    *(volatile uint32_t*)(TIMER_MTIMECMP + 4) = 0xFFFFFFFF; // No spurious match mid-update
+    *(volatile uint32_t*)TIMER_MTIMECMP = (uint32_t)deadline_us;
+    *(volatile uint32_t*)(TIMER_MTIMECMP + 4) = (uint32_t)(deadline_us >> 32);
+    asm volatile("csrs mie, %0" :: "r"(1u << 7));
+}
+
+inline void zenu_set_pan(int channel, uint8_t pan) {
+    *(volatile uint8_t*)(APU_REG_PAN + channel) = pan;
+}
+
 #endif
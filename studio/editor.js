@@ -97,6 +97,33 @@ eventSource.onmessage = (event) => {
     log(data.msg, data.msg.toLowerCase().includes('error') ? '#ff5555' : '#8b949e');
 };
 
+// --- Live Preview (frames streamed from the running game) ---
+const previewCanvas = document.getElementById('live-preview');
+const previewCtx = previewCanvas.getContext('2d');
+const previewSource = new EventSource('/preview');
+previewSource.addEventListener('frame', (event) => {
+    const bin = atob(event.data);
+    const bytes = new Uint8Array(bin.length);
+    for (let i = 0; i < bin.length; i++) bytes[i] = bin.charCodeAt(i);
+    const view = new DataView(bytes.buffer);
+    const width = view.getUint16(4, true), height = view.getUint16(6, true), rects = view.getUint16(8, true);
+    if (previewCanvas.width !== width || previewCanvas.height !== height) {
+        previewCanvas.width = width;
+        previewCanvas.height = height;
+    }
+    let off = 10;
+    for (let i = 0; i < rects; i++) {
+        const x = view.getUint16(off, true), y = view.getUint16(off + 2, true);
+        const w = view.getUint16(off + 4, true), h = view.getUint16(off + 6, true);
+        off += 8;
+        const pixels = new Uint8ClampedArray(bytes.buffer, off, w * h * 4);
+        previewCtx.putImageData(new ImageData(pixels, w, h), x, y);
+        off += w * h * 4;
+    }
+    previewCanvas.classList.remove('hidden');
+});
+previewSource.addEventListener('end', () => previewCanvas.classList.add('hidden'));
+
 // --- Viewport Graphics & Interaction ---
 function worldToScreen(x, y) {
     return {
@@ -1,5 +1,6 @@
 const express = require('express');
 const { exec, spawn } = require('child_process');
+const net = require('net');
 const fs = require('fs');
 const path = require('path');
 const cors = require('cors');
@@ -7,6 +8,7 @@ const multer = require('multer');
 
 const app = express();
 const port = 3000;
+const previewPort = 3001; // Games/emulator push frames here (ZENU_PREVIEW)
 
 app.use(cors());
 app.use(express.json());
@@ -15,7 +17,11 @@ app.use(express.static(__dirname));
 const upload = multer({ dest: 'assets/uploads/' });
 
 let gameProcess = null;
+let gameProject = null; // Project the running hot-reload host was started for
 let logClients = [];
+let previewClients = [];
+let previewFrame = null; // { width, height, rgba } composite, for late joiners
+let previewProducers = [];
 
 // Base paths
 const rootDir = path.join(__dirname, '..');
@@ -183,6 +189,104 @@ function broadcastLog(msg) {
     logClients.forEach(client => client.write(`data: ${data}\n\n`));
 }
 
+// Live Preview: producers connect over TCP and send length-prefixed,
+// tile-delta frames (see emulator/include/preview.hpp). Messages are relayed
+// to the browser as-is over SSE; the server keeps a composite so a newly
+// opened editor starts from a full picture.
+//
+// A tab that falls behind gets no deltas until its stream drains, then one
+// full frame. Once every tab is behind the producers are paused, so their
+// non-blocking sends fill up and PreviewStream skips frames at the source.
+const PREVIEW_MAGIC = 0x46504E5A;
+
+function applyPreviewMessage(msg) {
+    if (msg.length < 10 || msg.readUInt32LE(0) !== PREVIEW_MAGIC) return false;
+    const width = msg.readUInt16LE(4), height = msg.readUInt16LE(6), rects = msg.readUInt16LE(8);
+    if (!previewFrame || previewFrame.width !== width || previewFrame.height !== height) {
+        previewFrame = { width, height, rgba: Buffer.alloc(width * height * 4) };
+    }
+    let off = 10;
+    for (let i = 0; i < rects; i++) {
+        if (off + 8 > msg.length) return false;
+        const x = msg.readUInt16LE(off), y = msg.readUInt16LE(off + 2);
+        const w = msg.readUInt16LE(off + 4), h = msg.readUInt16LE(off + 6);
+        off += 8;
+        if (off + w * h * 4 > msg.length || x + w > width || y + h > height) return false;
+        for (let row = 0; row < h; row++) {
+            msg.copy(previewFrame.rgba, ((y + row) * width + x) * 4, off, off + w * 4);
+            off += w * 4;
+        }
+    }
+    return true;
+}
+
+function fullPreviewMessage() {
+    const { width, height, rgba } = previewFrame;
+    const header = Buffer.alloc(18);
+    header.writeUInt32LE(PREVIEW_MAGIC, 0);
+    header.writeUInt16LE(width, 4);
+    header.writeUInt16LE(height, 6);
+    header.writeUInt16LE(1, 8);
+    header.writeUInt16LE(0, 10);
+    header.writeUInt16LE(0, 12);
+    header.writeUInt16LE(width, 14);
+    header.writeUInt16LE(height, 16);
+    return Buffer.concat([header, rgba]);
+}
+
+function sendPreview(client, event, data) {
+    if (client.writableNeedDrain) return;
+    if (client.write(`event: ${event}\ndata: ${data}\n\n`)) return;
+    client.once('drain', () => {
+        if (previewFrame) sendPreview(client, 'frame', fullPreviewMessage().toString('base64'));
+        updatePreviewFlow();
+    });
+}
+
+function updatePreviewFlow() {
+    const stalled = previewClients.length > 0 && previewClients.every(client => client.writableNeedDrain);
+    previewProducers.forEach(socket => stalled ? socket.pause() : socket.resume());
+}
+
+function broadcastPreview(event, data) {
+    previewClients.forEach(client => sendPreview(client, event, data));
+    updatePreviewFlow();
+}
+
+net.createServer((socket) => {
+    let pending = Buffer.alloc(0);
+    previewProducers.push(socket);
+    broadcastLog('Live preview connected.');
+    socket.on('data', (chunk) => {
+        pending = Buffer.concat([pending, chunk]);
+        while (pending.length >= 4) {
+            const len = pending.readUInt32LE(0);
+            if (pending.length < 4 + len) break;
+            const msg = pending.subarray(4, 4 + len);
+            pending = pending.subarray(4 + len);
+            if (applyPreviewMessage(msg)) broadcastPreview('frame', msg.toString('base64'));
+        }
+    });
+    socket.on('close', () => {
+        previewProducers = previewProducers.filter(producer => producer !== socket);
+        broadcastPreview('end', '{}');
+    });
+    socket.on('error', () => {});
+}).listen(previewPort, '127.0.0.1');
+
+app.get('/preview', (req, res) => {
+    res.setHeader('Content-Type', 'text/event-stream');
+    res.setHeader('Cache-Control', 'no-cache');
+    res.setHeader('Connection', 'keep-alive');
+    previewClients.push(res);
+    if (previewFrame) sendPreview(res, 'frame', fullPreviewMessage().toString('base64'));
+    updatePreviewFlow();
+    req.on('close', () => {
+        previewClients = previewClients.filter(client => client !== res);
+        updatePreviewFlow();
+    });
+});
+
 function runCommand(command, args, cwd, onExit) {
     const child = spawn(command, args, { cwd });
     child.stdout.on('data', (data) => broadcastLog(data.toString().trim()));
@@ -195,19 +299,36 @@ function runCommand(command, args, cwd, onExit) {
     return child;
 }
 
+// The game runs in a hot-reload host (see Makefile.engine). While it is up
+// for the same project, Play only rebuilds the game library and the host
+// swaps it in without restarting.
 app.post('/run', (req, res) => {
+    const gameSrc = currentProject ? `game/${currentProject}/main.cpp` : 'game/main.cpp';
+    if (gameProcess && gameProject === currentProject) {
+        broadcastLog(`--- Hot Reload (${gameSrc}) ---`);
+        runCommand('make', ['-f', 'Makefile.engine', 'PLATFORM=PC', `GAME_SRC=${gameSrc}`, 'hot-lib'], rootDir, (code) => {
+            if (code === 0) res.send({ status: 'reloaded' });
+            else res.status(500).send('Build failed');
+        });
+        return;
+    }
     if (gameProcess) {
         broadcastLog('Stopping previous game process...');
         gameProcess.kill();
+        gameProcess = null;
     }
-    const gameSrc = currentProject ? `game/${currentProject}/main.cpp` : 'game/main.cpp';
     broadcastLog(`--- Starting PC Build & Run (${gameSrc}) ---`);
-    runCommand('make', ['-f', 'Makefile.engine', 'PLATFORM=PC', `GAME_SRC=${gameSrc}`], rootDir, (code) => {
+    runCommand('make', ['-f', 'Makefile.engine', 'PLATFORM=PC', `GAME_SRC=${gameSrc}`, 'hot'], rootDir, (code) => {
         if (code === 0) {
             broadcastLog('Launching game...');
-            gameProcess = spawn('./build/game', [], { cwd: rootDir });
-            gameProcess.stdout.on('data', (data) => broadcastLog(`[Game] ${data.toString().trim()}`));
-            gameProcess.stderr.on('data', (data) => broadcastLog(`[Game Error] ${data.toString().trim()}`));
+            const env = { ...process.env, ZENU_PREVIEW: `127.0.0.1:${previewPort}` };
+            const lib = `build/lib${currentProject || 'game'}.so`;
+            const child = spawn('./build/game-host', [lib], { cwd: rootDir, env });
+            child.stdout.on('data', (data) => broadcastLog(`[Game] ${data.toString().trim()}`));
+            child.stderr.on('data', (data) => broadcastLog(`[Game Error] ${data.toString().trim()}`));
+            child.on('close', () => { if (gameProcess === child) gameProcess = null; });
+            gameProcess = child;
+            gameProject = currentProject;
             res.send({ status: 'running' });
         } else {
             res.status(500).send('Build failed');